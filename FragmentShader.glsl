@@ -4,8 +4,23 @@ out vec4 FragColor;
 in vec2 TexCoord;
 
 uniform sampler2D ourTexture;
+uniform sampler1D colormap;
+
+// окно/уровень в долях диапазона текстуры [0..1]
+uniform float windowLow = 0.0;
+uniform float windowHigh = 1.0;
+uniform float gamma = 1.0;
+uniform bool useColormap = false;
 
 void main() {
     float value = texture(ourTexture, TexCoord).r;
-    FragColor = vec4(value, value, value, 1.0);
+
+    float t = clamp((value - windowLow) / max(windowHigh - windowLow, 1e-6), 0.0, 1.0);
+    t = pow(t, 1.0 / gamma);
+
+    if(useColormap) {
+        FragColor = vec4(texture(colormap, t).rgb, 1.0);
+    } else {
+        FragColor = vec4(t, t, t, 1.0);
+    }
 }
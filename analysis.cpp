@@ -0,0 +1,234 @@
+#include "analysis.h"
+#include <algorithm>
+#include <cmath>
+
+cv::Mat GenerateCircleImage(int width, int height, int radius) {
+    cv::Mat image(height, width, CV_8UC1, cv::Scalar(0));
+    
+    // Рисуем круг в центре изображения
+    cv::Point center(width/2, height/2);
+    cv::circle(image, center, radius, cv::Scalar(255), -1);
+    
+    // Применяем размытие
+    cv::GaussianBlur(image, image, cv::Size(5, 5), 2.0);
+    
+    return image;
+}
+
+void AnalyzeImage(AnalysisContext& context, const cv::Mat& image, const cv::Point& center, int radius,
+                  ImageAnalysisResult& result) {
+    result.centerX = center.x;
+    result.centerY = center.y;
+    result.radius = radius;
+    
+    // Векторы результата очищаются, но сохраняют ёмкость между вызовами
+    result.edgeProfile.clear();
+    result.edgeProfile.reserve(2 * static_cast<size_t>(std::max(radius, 0)) + 1);
+    
+    // Анализ профиля края
+    for (int r = -radius; r <= radius; ++r) {
+        double sum = 0;
+        int count = 0;
+        
+        for (int theta = 0; theta < 360; theta += 1) {
+            double rad = theta * CV_PI / 180.0;
+            int x = static_cast<int>(center.x + r * std::cos(rad));
+            int y = static_cast<int>(center.y + r * std::sin(rad));
+            
+            if (x >= 0 && x < image.cols && y >= 0 && y < image.rows) {
+                sum += static_cast<double>(image.at<uchar>(y, x));
+                count++;
+            }
+        }
+        
+        if (count > 0) {
+            result.edgeProfile.push_back(sum / static_cast<double>(count));
+        }
+    }
+    
+    // Анализ шума
+    cv::Rect roiRect(
+        std::max(0, center.x - radius/2),
+        std::max(0, center.y - radius/2),
+        std::min(radius, image.cols - center.x + radius/2),
+        std::min(radius, image.rows - center.y + radius/2)
+    );
+    cv::Mat roi = image(roiRect);
+    
+    auto meanFilteredBuffer = context.pool.Acquire(roi.size(), roi.type());
+    cv::Mat& meanFiltered = *meanFilteredBuffer;
+    cv::blur(roi, meanFiltered, cv::Size(3, 3));
+    
+    result.noiseProfile.clear();
+    result.noiseProfile.reserve(roi.rows);
+    for (int y = 0; y < roi.rows; ++y) {
+        double rowNoise = 0;
+        for (int x = 0; x < roi.cols; ++x) {
+            double diff = static_cast<double>(roi.at<uchar>(y, x)) - static_cast<double>(meanFiltered.at<uchar>(y, x));
+            rowNoise += diff * diff;
+        }
+        result.noiseProfile.push_back(std::sqrt(rowNoise / static_cast<double>(roi.cols)));
+    }
+    
+    // Расчет статистик
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(roi, mean, stddev);
+    
+    result.signalMean = mean[0];
+    result.noiseStd = stddev[0];
+    result.cnr = (stddev[0] > 0) ? (mean[0] / stddev[0]) : 0;
+}
+
+ImageAnalysisResult AnalyzeImage(const cv::Mat& image, const cv::Point& center, int radius) {
+    AnalysisContext context;
+    ImageAnalysisResult result;
+    AnalyzeImage(context, image, center, radius, result);
+    return result;
+}
+
+bool DetectCircle(AnalysisContext& context, const cv::Mat& image, cv::Point& center, int& radius) {
+    auto edgesBuffer = context.pool.Acquire(image.size(), CV_8UC1);
+    cv::Mat& edges = *edgesBuffer;
+    cv::Canny(image, edges, 100, 200);    
+
+    int dp = 1;
+    int minDist = 20;
+    int param1 = 10;
+    int param2 = 10;
+    int minRadius = 0;
+    int maxRadius = 0;
+
+    std::vector<cv::Vec3f>& circles = context.circles;
+    cv::HoughCircles(edges, circles, cv::HOUGH_GRADIENT, dp, minDist, param1, param2, minRadius, maxRadius);
+    
+    if (circles.empty()) {
+        return false;
+    }
+    
+    cv::Vec3f circle = circles[0];
+    center = cv::Point(cvRound(circle[0]), cvRound(circle[1]));
+    radius = cvRound(circle[2]);
+    return true;
+}
+
+bool DetectCircle(const cv::Mat& image, cv::Point& center, int& radius) {
+    AnalysisContext context;
+    return DetectCircle(context, image, center, radius);
+}
+
+void ComputeResponseFunction(const ImageAnalysisResult& analysis, std::vector<float>& responseFunction) {
+    responseFunction.clear();
+    responseFunction.reserve(analysis.edgeProfile.size());
+    for (size_t i = 1; i < analysis.edgeProfile.size(); ++i) {
+        responseFunction.push_back(static_cast<float>(
+            analysis.edgeProfile[i] - analysis.edgeProfile[i-1]
+        ));
+    }
+}
+
+bool CalculateEdgeResponse(AnalysisContext& context, const cv::Mat& image,
+                           ImageAnalysisResult& analysis, std::vector<float>& responseFunction) {
+    cv::Point center;
+    int radius = 0;
+    if (!DetectCircle(context, image, center, radius)) {
+        return false;
+    }
+    
+    AnalyzeImage(context, image, center, radius, analysis);
+    ComputeResponseFunction(analysis, responseFunction);
+    return true;
+}
+
+cv::Mat DrawDetectedCircle(const cv::Mat& image, const ImageAnalysisResult& analysis) {
+    // поскольку изображение ч/б выделяем белым тонким кругом обведённым для контраста 2 чёрными
+    cv::Point center(analysis.centerX, analysis.centerY);
+    int radius = analysis.radius;
+    
+    cv::Mat marked = image.clone();
+    cv::circle(marked, center, radius - 1, cv::Scalar(0), 1);
+    cv::circle(marked, center, radius + 0, cv::Scalar(255), 1);
+    cv::circle(marked, center, radius + 1, cv::Scalar(0), 1);
+    return marked;
+}
+
+json AnalysisToJson(const ImageAnalysisResult& analysis) {
+    json data;
+    
+    if (!analysis.edgeProfile.empty()) {
+        data["edgeProfile"] = analysis.edgeProfile;
+        data["noiseProfile"] = analysis.noiseProfile;
+        data["signalMean"] = analysis.signalMean;
+        data["noiseStd"] = analysis.noiseStd;
+        data["cnr"] = analysis.cnr;
+        data["centerX"] = analysis.centerX;
+        data["centerY"] = analysis.centerY;
+        data["radius"] = analysis.radius;
+    }
+    
+    return data;
+}
+
+cv::Mat SharpenFilter(const cv::Mat& from, AnalysisContext& context)
+{
+    // sharpen image using "unsharp mask" algorithm
+    auto blurredBuffer = context.pool.Acquire(from.size(), from.type());
+    auto diffBuffer = context.pool.Acquire(from.size(), from.type());
+    auto maskBuffer = context.pool.Acquire(from.size(), CV_8UC1);
+    cv::Mat& blurred = *blurredBuffer;
+    cv::Mat& diff = *diffBuffer;
+    cv::Mat& lowContrastMask = *maskBuffer;
+
+    double sigma = 1, threshold = 5, amount = 1;
+    cv::GaussianBlur(from, blurred, cv::Size(), sigma, sigma);
+
+    // маска |from - blurred| < threshold; absdiff не насыщает отрицательную разность в ноль
+    cv::absdiff(from, blurred, diff);
+    cv::compare(diff, threshold, lowContrastMask, cv::CMP_LT);
+
+    cv::Mat sharpened;
+    cv::addWeighted(from, 1 + amount, blurred, -amount, 0, sharpened);
+    from.copyTo(sharpened, lowContrastMask);
+
+    return sharpened;
+}
+cv::Mat GaussBlurFilter(const cv::Mat& from, AnalysisContext&)
+{
+    cv::Mat blurred;
+    double sigma = 1;
+    cv::GaussianBlur(from, blurred, cv::Size(), sigma, sigma);
+
+    return blurred;
+}
+
+cv::Mat LaplaceOperator(const cv::Mat& from, AnalysisContext& context)
+{
+    int kernel_size = 3,
+        scale = 1,
+        delta = 0;
+
+    // Laplacian допускает CV_16S только для 8-битного источника;
+    // 16-битным нужен CV_32F, вещественные считаются в своей точности
+    int ddepth = CV_16S;
+    if (from.depth() == CV_16U || from.depth() == CV_16S) ddepth = CV_32F;
+    else if (from.depth() == CV_32F || from.depth() == CV_64F) ddepth = from.depth();
+
+    auto dstBuffer = context.pool.Acquire(from.size(), CV_MAKETYPE(ddepth, from.channels()));
+    cv::Mat& dst = *dstBuffer;
+    cv::Mat abs_dst;
+    cv::Laplacian(from, dst, ddepth, kernel_size, scale, delta, cv::BORDER_DEFAULT);
+
+    if (from.depth() == CV_8U) {
+        // converting back to CV_8U
+        cv::convertScaleAbs(dst, abs_dst);
+    } else {
+        // модуль без насыщения до 255, в вещественном типе
+        abs_dst = cv::abs(dst);
+    }
+
+    return abs_dst;
+}
+
+cv::Mat NoiseFilter(const cv::Mat& from, const NoiseParams& params)
+{
+    return AddNoise(from, params);
+}
@@ -0,0 +1,53 @@
+#pragma once
+// Ядро анализа: синтез, детекция круга, расчёт функции отклика и фильтры.
+// Не зависит от OpenGL/ImGui и не использует глобального состояния —
+// всё изменяемое передаётся явно через AnalysisContext, так что независимые
+// анализы можно запускать параллельно, по контексту на поток.
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "analysis_context.h"
+#include "noise.h"
+
+using json = nlohmann::json;
+
+// Структура для результатов анализа
+struct ImageAnalysisResult {
+    std::vector<double> edgeProfile;
+    std::vector<double> noiseProfile;
+    double signalMean = 0.0;
+    double noiseStd = 0.0;
+    double cnr = 0.0;
+    int centerX = 0;
+    int centerY = 0;
+    int radius = 0;
+};
+
+// Синтез тестового изображения: размытый белый круг в центре
+cv::Mat GenerateCircleImage(int width, int height, int radius);
+
+bool DetectCircle(const cv::Mat& image, cv::Point& center, int& radius);
+bool DetectCircle(AnalysisContext& context, const cv::Mat& image, cv::Point& center, int& radius);
+
+ImageAnalysisResult AnalyzeImage(const cv::Mat& image, const cv::Point& center, int radius);
+void AnalyzeImage(AnalysisContext& context, const cv::Mat& image, const cv::Point& center, int radius,
+                  ImageAnalysisResult& result);
+
+// Производная профиля края
+void ComputeResponseFunction(const ImageAnalysisResult& analysis, std::vector<float>& responseFunction);
+
+// Полный расчёт: детекция + анализ + функция отклика; false если круг не найден
+bool CalculateEdgeResponse(AnalysisContext& context, const cv::Mat& image,
+                           ImageAnalysisResult& analysis, std::vector<float>& responseFunction);
+
+// Копия изображения с обведённым найденным кругом
+cv::Mat DrawDetectedCircle(const cv::Mat& image, const ImageAnalysisResult& analysis);
+
+json AnalysisToJson(const ImageAnalysisResult& analysis);
+
+cv::Mat SharpenFilter(const cv::Mat& from, AnalysisContext& context);
+cv::Mat GaussBlurFilter(const cv::Mat& from, AnalysisContext& context);
+// Модуль лапласиана: для 8-битного источника в CV_8U, для остальных — в CV_32F (CV_64F для double)
+cv::Mat LaplaceOperator(const cv::Mat& from, AnalysisContext& context);
+cv::Mat NoiseFilter(const cv::Mat& from, const NoiseParams& params);
@@ -0,0 +1,80 @@
+#include "analysis_context.h"
+
+static size_t MatBytes(const cv::Mat& mat) {
+    return mat.total() * mat.elemSize();
+}
+
+BufferPool::Buffer BufferPool::Acquire(cv::Size size, int type) {
+    ++stats.acquired;
+
+    auto it = freeBuffers.find(Key(size.height, size.width, type));
+    if (it != freeBuffers.end()) {
+        cv::Mat mat = std::move(it->second.buffers.back());
+        it->second.buffers.pop_back();
+        if (it->second.buffers.empty()) freeBuffers.erase(it);
+
+        --stats.pooledBuffers;
+        stats.pooledBytes -= MatBytes(mat);
+        return Buffer(*this, std::move(mat));
+    }
+
+    ++stats.allocated;
+    return Buffer(*this, cv::Mat(size, type));
+}
+
+void BufferPool::Release(cv::Mat& mat) {
+    // Не забираем буфер, если на его данные ещё кто-то ссылается,
+    // а также подматрицы — их память принадлежит другому Mat
+    bool shared = mat.u && mat.u->refcount > 1;
+    if (mat.empty() || shared || mat.isSubmatrix() || mat.dims > 2) {
+        mat.release();
+        return;
+    }
+
+    Key key(mat.rows, mat.cols, mat.type());
+    size_t bytes = MatBytes(mat);
+
+    auto it = freeBuffers.find(key);
+    bool full = it != freeBuffers.end() && it->second.buffers.size() >= perKeyLimit;
+    if (full || !EvictFor(bytes, key)) {
+        if (it != freeBuffers.end()) it->second.lastUse = ++tick;
+        mat.release();
+        return;
+    }
+
+    Slot& slot = freeBuffers[key];
+    slot.lastUse = ++tick;
+    slot.buffers.push_back(std::move(mat));
+
+    stats.pooledBytes += bytes;
+    ++stats.pooledBuffers;
+}
+
+bool BufferPool::EvictFor(size_t bytes, const Key& keep) {
+    if (bytes > limitBytes) return false;
+
+    while (stats.pooledBytes + bytes > limitBytes) {
+        auto oldest = freeBuffers.end();
+        for (auto it = freeBuffers.begin(); it != freeBuffers.end(); ++it) {
+            if (it->first == keep) continue;
+            if (oldest == freeBuffers.end() || it->second.lastUse < oldest->second.lastUse) oldest = it;
+        }
+        // Остались только буферы того же размера — они и так ещё пригодятся
+        if (oldest == freeBuffers.end()) return false;
+
+        for (const cv::Mat& mat : oldest->second.buffers) {
+            stats.pooledBytes -= MatBytes(mat);
+            --stats.pooledBuffers;
+            ++stats.evicted;
+        }
+        freeBuffers.erase(oldest);
+    }
+
+    return true;
+}
+
+void BufferPool::Clear() {
+    freeBuffers.clear();
+    stats.pooledBuffers = 0;
+    stats.pooledBytes = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Пул временных буферов, ключ — (строки, столбцы, тип).
+// Буферы переиспользуются между вызовами и кадрами вместо новых аллокаций.
+// Не потокобезопасен: у каждого потока свой пул (см. AnalysisContext).
+class BufferPool {
+public:
+    struct Stats {
+        size_t acquired = 0;      // всего запрошено буферов
+        size_t allocated = 0;     // из них пришлось выделить заново
+        size_t pooledBuffers = 0; // свободных буферов в пуле сейчас
+        size_t pooledBytes = 0;
+        size_t evicted = 0;       // вытеснено ради буферов других размеров
+    };
+
+    // RAII-хэндл: при разрушении буфер возвращается в пул
+    class Buffer {
+    public:
+        Buffer(BufferPool& pool, cv::Mat mat) : pool(&pool), mat(std::move(mat)) {}
+        Buffer(Buffer&& other) noexcept : pool(other.pool), mat(std::move(other.mat)) { other.pool = nullptr; }
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+        Buffer& operator=(Buffer&&) = delete;
+        ~Buffer() { if (pool) pool->Release(mat); }
+
+        cv::Mat& operator*() { return mat; }
+        cv::Mat* operator->() { return &mat; }
+
+    private:
+        BufferPool* pool;
+        cv::Mat mat;
+    };
+
+    // Кроме общего лимита по памяти ограничено и число свободных буферов одного размера:
+    // фильтры держат одновременно не больше двух, лишние только занимали бы память
+    explicit BufferPool(size_t maxPooledBytes = size_t(256) << 20, size_t maxBuffersPerKey = 4)
+        : limitBytes(maxPooledBytes), perKeyLimit(maxBuffersPerKey) {}
+
+    Buffer Acquire(cv::Size size, int type);
+    void Clear();
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    using Key = std::tuple<int, int, int>;
+
+    struct Slot {
+        std::vector<cv::Mat> buffers;
+        uint64_t lastUse = 0;
+    };
+
+    void Release(cv::Mat& mat);
+    // Освобождает место, выбрасывая буферы давно не использовавшихся размеров
+    bool EvictFor(size_t bytes, const Key& keep);
+
+    // Пустых ключей в словаре не бывает: размер, который перестал встречаться,
+    // уходит из пула целиком при вытеснении
+    std::map<Key, Slot> freeBuffers;
+    size_t limitBytes;
+    size_t perKeyLimit;
+    uint64_t tick = 0;
+    Stats stats;
+};
+
+// Контекст анализа: владеет пулом буферов и прочими данными, переживающими вызов.
+// Один контекст — один поток; для параллельной работы заводится по контексту на поток.
+struct AnalysisContext {
+    BufferPool pool;
+    std::vector<cv::Vec3f> circles;
+};
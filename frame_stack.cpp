@@ -0,0 +1,111 @@
+#include "frame_stack.h"
+#include <algorithm>
+#include <future>
+
+namespace {
+
+template<typename T>
+void WelfordRows(const cv::Mat& frame, cv::Mat& mean, cv::Mat& m2, double n, const cv::Range& rows) {
+    const double invN = 1.0 / n;
+
+    for (int y = rows.start; y < rows.end; ++y) {
+        const T* x = frame.ptr<T>(y);
+        double* mu = mean.ptr<double>(y);
+        double* s = m2.ptr<double>(y);
+
+        for (int i = 0; i < frame.cols; ++i) {
+            double value = static_cast<double>(x[i]);
+            double delta = value - mu[i];
+            mu[i] += delta * invN;
+            s[i] += delta * (value - mu[i]);
+        }
+    }
+}
+
+template<typename T>
+void WelfordUpdate(const cv::Mat& frame, cv::Mat& mean, cv::Mat& m2, size_t count) {
+    // Полосы строк независимы, результат не зависит от разбиения на потоки
+    double stripes = std::max(1.0, frame.rows / 32.0);
+
+    cv::parallel_for_(cv::Range(0, frame.rows), [&](const cv::Range& rows) {
+        WelfordRows<T>(frame, mean, m2, static_cast<double>(count), rows);
+    }, stripes);
+}
+
+} // namespace
+
+bool FrameStackAccumulator::Add(const cv::Mat& frame) {
+    if (frame.empty() || frame.channels() != 1) return false;
+
+    if (count == 0) {
+        mean = cv::Mat::zeros(frame.size(), CV_64F);
+        m2 = cv::Mat::zeros(frame.size(), CV_64F);
+        depth = frame.depth();
+    } else if (frame.size() != mean.size() || frame.depth() != depth) {
+        return false;
+    }
+
+    ++count;
+
+    switch (frame.depth()) {
+    case CV_8U:  WelfordUpdate<uchar>(frame, mean, m2, count); break;
+    case CV_16U: WelfordUpdate<ushort>(frame, mean, m2, count); break;
+    case CV_32F: WelfordUpdate<float>(frame, mean, m2, count); break;
+    case CV_64F: WelfordUpdate<double>(frame, mean, m2, count); break;
+    default: {
+        cv::Mat converted;
+        frame.convertTo(converted, CV_64F);
+        WelfordUpdate<double>(converted, mean, m2, count);
+    }
+    }
+
+    return true;
+}
+
+void FrameStackAccumulator::Reset() {
+    mean.release();
+    m2.release();
+    count = 0;
+    depth = -1;
+}
+
+cv::Mat FrameStackAccumulator::Variance() const {
+    if (count < 2) return cv::Mat::zeros(mean.size(), CV_64F);
+    return m2 / static_cast<double>(count - 1);
+}
+
+cv::Mat FrameStackAccumulator::StdDev() const {
+    cv::Mat stddev;
+    cv::sqrt(Variance(), stddev);
+    return stddev;
+}
+
+bool AccumulateFrameStack(const std::vector<std::string>& paths, FrameStackResult& result) {
+    auto load = [](const std::string& path) {
+        return cv::imread(path, cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH);
+    };
+
+    FrameStackAccumulator accumulator;
+    size_t skipped = 0;
+
+    std::future<cv::Mat> next;
+    if (!paths.empty()) next = std::async(std::launch::async, load, paths[0]);
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        cv::Mat frame = next.get();
+
+        // В памяти одновременно не больше двух кадров: текущий и следующий
+        if (i + 1 < paths.size()) next = std::async(std::launch::async, load, paths[i + 1]);
+
+        if (!accumulator.Add(frame)) ++skipped;
+    }
+
+    result.frames = accumulator.Count();
+    result.skipped = skipped;
+    result.depth = accumulator.Depth();
+    if (result.frames == 0) return false;
+
+    result.mean = accumulator.Mean();
+    result.noiseStd = accumulator.StdDev();
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// Однопроходное накопление попиксельных среднего и дисперсии по серии кадров
+// (алгоритм Уэлфорда). Память постоянна и не зависит от числа кадров.
+class FrameStackAccumulator {
+public:
+    // Кадры должны быть одноканальными, одного размера и глубины; false если кадр не подходит
+    bool Add(const cv::Mat& frame);
+    void Reset();
+
+    size_t Count() const { return count; }
+    cv::Size Size() const { return mean.size(); }
+    // Глубина исходных кадров (CV_8U, CV_16U, ...), -1 пока кадров нет
+    int Depth() const { return depth; }
+
+    // CV_64F; дисперсия — выборочная (делитель n - 1)
+    cv::Mat Mean() const { return mean; }
+    cv::Mat Variance() const;
+    cv::Mat StdDev() const;
+
+private:
+    cv::Mat mean;
+    cv::Mat m2;
+    size_t count = 0;
+    int depth = -1;
+};
+
+struct FrameStackResult {
+    cv::Mat mean;       // CV_64F
+    cv::Mat noiseStd;   // CV_64F
+    int depth = -1;     // глубина исходных кадров: среднее и СКО в их шкале (для CV_16U — до 65535)
+    size_t frames = 0;
+    size_t skipped = 0; // не прочитались или не совпали по размеру или глубине
+};
+
+// Читает кадры с диска по одному (следующий декодируется, пока накапливается текущий).
+// 16-битные кадры читаются без потери разрядности.
+bool AccumulateFrameStack(const std::vector<std::string>& paths, FrameStackResult& result);
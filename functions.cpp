@@ -3,18 +3,36 @@
 #include "tinyfiledialogs.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <sstream>
+
+#include "frame_stack.h"
 
 ImageAnalysisResult currentAnalysis;
+std::unique_ptr<ImageFolderCache> imageFolder;
+AnalysisContext analysisContext;
+
+// Изображения показываются в исходной разрядности, а анализ (Canny, профили) работает с 8 битами.
+// Шкала — по фактическому диапазону: 16-битные кадры обычно несут 12–14 значащих бит.
+static cv::Mat AnalysisImage(const cv::Mat& image) {
+    if (image.depth() == CV_8U) return image;
+
+    cv::Mat image8;
+    cv::normalize(image, image8, 0, 255, cv::NORM_MINMAX, CV_8U);
+    return image8;
+}
+
+// Текстура и файл бывают 8- или 16-битными; прочее (например, модуль лапласиана в float) растягиваем в 8 бит
+static cv::Mat DisplayImage(const cv::Mat& image) {
+    if (image.depth() == CV_8U || image.depth() == CV_16U) return image;
+
+    cv::Mat image8;
+    cv::normalize(image, image8, 0, 255, cv::NORM_MINMAX, CV_8U);
+    return image8;
+}
 
 void GenerateCustomCircle(int width, int height, int radius) {
-    *currentImage = cv::Mat(height, width, CV_8UC1, cv::Scalar(0));
-    
-    // Рисуем круг в центре изображения
-    cv::Point center(width/2, height/2);
-    cv::circle(*currentImage, center, radius, cv::Scalar(255), -1);
-    
-    // Применяем размытие
-    cv::GaussianBlur(*currentImage, *currentImage, cv::Size(5, 5), 2.0);
+    *currentImage = GenerateCircleImage(width, height, radius);
     
     UpdateImageTexture(*currentImage, *currentImageID);
     outputMessage = "Custom circle generated";
@@ -31,73 +49,121 @@ void LoadImage() {
     );
     
     if (filepath) {
-        *currentImage = cv::imread(filepath, cv::IMREAD_GRAYSCALE);
-        if (!currentImage->empty()) {
+        if (!imageFolder) imageFolder = std::make_unique<ImageFolderCache>();
+
+        if (imageFolder->Open(filepath, *currentImage)) {
             UpdateImageTexture(*currentImage, *currentImageID);
             outputMessage = "Image loaded successfully";
         } else {
-            outputMessage = "Failed to load image";
+            outputMessage = "Failed to load image " + imageFolder->FailedPath();
         }
     }
 }
 
-ImageAnalysisResult AnalyzeImage(const cv::Mat& image, const cv::Point& center, int radius) {
-    ImageAnalysisResult result;
-    result.centerX = center.x;
-    result.centerY = center.y;
-    result.radius = radius;
+// Переход к соседнему файлу в папке, step = +1 или -1
+static void StepImage(int step) {
+    if (!imageFolder || !imageFolder->IsOpen()) {
+        outputMessage = "No folder opened";
+        return;
+    }
+
+    bool available = (step > 0) ? imageFolder->HasNext() : imageFolder->HasPrevious();
+    if (!available) {
+        outputMessage = (step > 0) ? "Last image in folder" : "First image in folder";
+        return;
+    }
+
+    size_t previous = imageFolder->Position();
+    bool loaded = (step > 0) ? imageFolder->Next(*currentImage)
+                             : imageFolder->Previous(*currentImage);
+    if (!loaded) {
+        outputMessage = "Failed to load image " + imageFolder->FailedPath();
+        return;
+    }
+
+    UpdateImageTexture(*currentImage, *currentImageID);
+    outputMessage = "Image " + std::to_string(imageFolder->Position() + 1) +
+                    " / " + std::to_string(imageFolder->Count()) + ": " + imageFolder->CurrentPath();
+
+    // Пропущенные нечитаемые файлы между прежней и новой позицией
+    size_t distance = (step > 0) ? imageFolder->Position() - previous : previous - imageFolder->Position();
+    if (distance > 1) {
+        outputMessage += " (skipped " + std::to_string(distance - 1) + " unreadable, last " +
+                         imageFolder->FailedPath() + ")";
+    }
+}
+
+bool LoadFrameStack() {
+    const char* selection = tinyfd_openFileDialog(
+        "Choose frames of the stack",
+        "",
+        0,
+        nullptr,
+        nullptr,
+        1
+    );
     
-    // Анализ профиля края
-    for (int r = -radius; r <= radius; ++r) {
-        double sum = 0;
-        int count = 0;
-        
-        for (int theta = 0; theta < 360; theta += 1) {
-            double rad = theta * CV_PI / 180.0;
-            int x = static_cast<int>(center.x + r * std::cos(rad));
-            int y = static_cast<int>(center.y + r * std::sin(rad));
-            
-            if (x >= 0 && x < image.cols && y >= 0 && y < image.rows) {
-                sum += static_cast<double>(image.at<uchar>(y, x));
-                count++;
-            }
-        }
-        
-        if (count > 0) {
-            result.edgeProfile.push_back(sum / static_cast<double>(count));
-        }
+    if (!selection) return false;
+    
+    // при множественном выборе пути разделены символом '|'
+    std::vector<std::string> paths;
+    std::stringstream stream(selection);
+    for (std::string path; std::getline(stream, path, '|');) {
+        if (!path.empty()) paths.push_back(path);
     }
+    std::sort(paths.begin(), paths.end(), NaturalPathLess);
     
-    // Анализ шума
-    cv::Rect roiRect(
-        std::max(0, center.x - radius/2),
-        std::max(0, center.y - radius/2),
-        std::min(radius, image.cols - center.x + radius/2),
-        std::min(radius, image.rows - center.y + radius/2)
-    );
-    cv::Mat roi = image(roiRect);
+    FrameStackResult stack;
+    if (!AccumulateFrameStack(paths, stack)) {
+        outputMessage = "Failed to load frame stack";
+        return false;
+    }
     
-    cv::Mat meanFiltered;
-    cv::blur(roi, meanFiltered, cv::Size(3, 3));
+    // Анализ края ведётся по среднему кадру — детерминированная часть без шума.
+    // Конвертируем в новые Mat: прежние данные *currentImage и *processedImage
+    // могут разделяться с кэшем папки, писать в них на месте нельзя.
+    // Среднее показываем в разрядности кадров, анализу отдаём 8-битную копию
+    // со шкалой по фактическому диапазону (см. AnalysisImage)
+    cv::Mat mean;
+    if (stack.depth == CV_8U || stack.depth == CV_16U) {
+        stack.mean.convertTo(mean, stack.depth);
+    } else {
+        cv::normalize(stack.mean, mean, 0, 255, cv::NORM_MINMAX, CV_8U);
+    }
+    *currentImage = mean;
+    UpdateImageTexture(*currentImage, *currentImageID);
     
-    for (int y = 0; y < roi.rows; ++y) {
-        double rowNoise = 0;
-        for (int x = 0; x < roi.cols; ++x) {
-            double diff = static_cast<double>(roi.at<uchar>(y, x)) - static_cast<double>(meanFiltered.at<uchar>(y, x));
-            rowNoise += diff * diff;
-        }
-        result.noiseProfile.push_back(std::sqrt(rowNoise / static_cast<double>(roi.cols)));
+    bool detected = CalculateEdgeResponse(analysisContext, AnalysisImage(*currentImage), currentAnalysis, responseFunction);
+    if (!detected) {
+        // результаты прошлого изображения к этой серии не относятся
+        currentAnalysis = ImageAnalysisResult();
+        responseFunction.clear();
     }
     
-    // Расчет статистик
-    cv::Scalar mean, stddev;
-    cv::meanStdDev(roi, mean, stddev);
+    // Карту СКО шума растягиваем на весь диапазон для просмотра
+    cv::Mat noiseMap;
+    cv::normalize(stack.noiseStd, noiseMap, 0, 255, cv::NORM_MINMAX, CV_8U);
+    *processedImage = noiseMap;
+    UpdateImageTexture(*processedImage, *processedImageID);
     
-    result.signalMean = mean[0];
-    result.noiseStd = stddev[0];
-    result.cnr = (stddev[0] > 0) ? (mean[0] / stddev[0]) : 0;
+    outputMessage = "Stacked " + std::to_string(stack.frames) + " frames";
+    if (stack.skipped > 0) {
+        outputMessage += " (" + std::to_string(stack.skipped) + " skipped)";
+    }
+    outputMessage += ", mean noise std " + std::to_string(cv::mean(stack.noiseStd)[0]);
+    if (!detected) {
+        outputMessage += ". No circles detected";
+    }
     
-    return result;
+    return true;
+}
+
+void LoadNextImage() {
+    StepImage(+1);
+}
+
+void LoadPreviousImage() {
+    StepImage(-1);
 }
 
 void CalculateResponseFunction() {
@@ -106,50 +172,24 @@ void CalculateResponseFunction() {
         return;
     }
     
-    cv::Mat edges;
-    cv::Canny(*currentImage, edges, 100, 200);    
-
-    int dp = 1;
-    int minDist = 20;
-    int param1 = 10;
-    int param2 = 10;
-    int minRadius = 0;
-    int maxRadius = 0;
-
-    std::vector<cv::Vec3f> circles;
-    cv::HoughCircles(edges, circles, cv::HOUGH_GRADIENT, dp, minDist, param1, param2, minRadius, maxRadius);
-    
-    if (circles.empty()) {
+    cv::Mat image = AnalysisImage(*currentImage);
+    if (!CalculateEdgeResponse(analysisContext, image, currentAnalysis, responseFunction)) {
+        currentAnalysis = ImageAnalysisResult();
+        responseFunction.clear();
         outputMessage = "No circles detected";
         return;
     }
-    
-    cv::Vec3f circle = circles[0];
-    cv::Point center(cvRound(circle[0]), cvRound(circle[1]));
-    int radius = cvRound(circle[2]);
-    
-    currentAnalysis = AnalyzeImage(*currentImage, center, radius);
-    
-    responseFunction.clear();
-    for (size_t i = 1; i < currentAnalysis.edgeProfile.size(); ++i) {
-        responseFunction.push_back(static_cast<float>(
-            currentAnalysis.edgeProfile[i] - currentAnalysis.edgeProfile[i-1]
-        ));
-    }
 
     // создаём найденный круг на обработанном изображении для наглядности
-    // поскольку изображение ч/б выделяем белым тонким кругом обведённым для контраста 2 чёрными
-    *processedImage = currentImage->clone();
-    cv::circle(*processedImage, center, radius - 1, cv::Scalar(0), 1);
-    cv::circle(*processedImage, center, radius + 0, cv::Scalar(255), 1);
-    cv::circle(*processedImage, center, radius + 1, cv::Scalar(0), 1);
+    *processedImage = DrawDetectedCircle(image, currentAnalysis);
     UpdateImageTexture(*processedImage, *processedImageID);
     
     outputMessage = "Analysis completed successfully";
 }
 
-void UpdateImageTexture(const cv::Mat& from, GLuint& textureID) {
-    if (from.empty()) return;
+void UpdateImageTexture(const cv::Mat& image, GLuint& textureID) {
+    if (image.empty()) return;
+    cv::Mat from = DisplayImage(image);
     
     if (textureID != 0) {
         glDeleteTextures(1, &textureID);
@@ -158,20 +198,111 @@ void UpdateImageTexture(const cv::Mat& from, GLuint& textureID) {
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
 
+    // 16-битные изображения грузим как есть, окно/уровень применяет шейдер
+    bool wide = from.depth() == CV_16U;
+    GLint internalFormat = wide ? GL_R16 : GL_R8;
+    GLenum pixelType = wide ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+
     // чтобы изображение не "ехало" по горизонтали
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, from.step/from.elemSize());
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, from.cols, from.rows,
-                 0, GL_RED, GL_UNSIGNED_BYTE, from.ptr());
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, from.cols, from.rows,
+                 0, GL_RED, pixelType, from.ptr());
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
+DisplaySettings displaySettings;
+
+// Расположение uniform-переменных, запрашивается один раз после загрузки шейдеров
+static struct ShaderUniforms {
+    GLint windowMode = -1;
+    GLint windowSize = -1;
+    GLint screenPos = -1;
+    GLint resolution = -1;
+    GLint windowLow = -1;
+    GLint windowHigh = -1;
+    GLint gamma = -1;
+    GLint useColormap = -1;
+} uniforms;
+
+static GLuint colormapTextureID = 0;
+
+static const char* colormapNames[] = {"Grayscale", "Jet", "Hot", "Bone", "Viridis", "Inferno"};
+static const int colormapTypes[] = {-1, cv::COLORMAP_JET, cv::COLORMAP_HOT, cv::COLORMAP_BONE,
+                                    cv::COLORMAP_VIRIDIS, cv::COLORMAP_INFERNO};
+
+void InitDisplayPipeline() {
+    uniforms.windowMode = glGetUniformLocation(programID, "windowMode");
+    uniforms.windowSize = glGetUniformLocation(programID, "windowSize");
+    uniforms.screenPos = glGetUniformLocation(programID, "screenPos");
+    uniforms.resolution = glGetUniformLocation(programID, "resolution");
+    uniforms.windowLow = glGetUniformLocation(programID, "windowLow");
+    uniforms.windowHigh = glGetUniformLocation(programID, "windowHigh");
+    uniforms.gamma = glGetUniformLocation(programID, "gamma");
+    uniforms.useColormap = glGetUniformLocation(programID, "useColormap");
+
+    // сэмплеры не меняются: изображение в юните 0, палитра в юните 1
+    glUseProgram(programID);
+    glUniform1i(glGetUniformLocation(programID, "ourTexture"), 0);
+    glUniform1i(glGetUniformLocation(programID, "colormap"), 1);
+    glUseProgram(0);
+
+    glGenTextures(1, &colormapTextureID);
+    UpdateColormap();
+}
+
+void ShutdownDisplayPipeline() {
+    if (colormapTextureID != 0) {
+        glDeleteTextures(1, &colormapTextureID);
+        colormapTextureID = 0;
+    }
+}
+
+void UpdateColormap() {
+    int type = colormapTypes[displaySettings.colormap];
+    if (type < 0) return; // серый считается прямо в шейдере
+
+    // 256 значений палитры OpenCV -> одномерная RGB текстура
+    cv::Mat ramp(1, 256, CV_8UC1);
+    for (int i = 0; i < 256; ++i) ramp.at<uchar>(0, i) = static_cast<uchar>(i);
+
+    cv::Mat lut;
+    cv::applyColorMap(ramp, lut, type);
+    cv::cvtColor(lut, lut, cv::COLOR_BGR2RGB);
+
+    glBindTexture(GL_TEXTURE_1D, colormapTextureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB8, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, lut.ptr());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+void RenderDisplayControls() {
+    ImGui::Text("Display:");
+    ImGui::SliderFloat("Level", &displaySettings.level, 0.0f, 1.0f, "%.3f");
+    ImGui::SliderFloat("Window", &displaySettings.width, 0.001f, 1.0f, "%.3f");
+    ImGui::SliderFloat("Gamma", &displaySettings.gamma, 0.2f, 5.0f, "%.2f");
+
+    if (ImGui::Combo("Colormap", &displaySettings.colormap, colormapNames, IM_ARRAYSIZE(colormapNames))) {
+        UpdateColormap();
+    }
+
+    if (ImGui::Button("Reset Display", ImVec2(200, 30))) {
+        int colormap = displaySettings.colormap;
+        displaySettings = DisplaySettings();
+        displaySettings.colormap = colormap;
+    }
+}
+
 static struct CallbackData {
     ImVec2 pos;
     ImVec2 size;
@@ -188,10 +319,24 @@ static void draw_callback(const ImDrawList* parent_list, const ImDrawCmd* cmd)
     const auto& [pos, size, textureID] = *(CallbackData*)cmd->UserCallbackData;
 
     // отправка инфы про окно в вертексный шейдер
-    glUniform1i(glGetUniformLocation(programID, "windowMode"), 1);
-    glUniform2f(glGetUniformLocation(programID, "windowSize"), size.x, size.y);
-    glUniform2f(glGetUniformLocation(programID, "screenPos"), pos.x, pos.y);
-    glUniform2f(glGetUniformLocation(programID, "resolution"), resolution.x, resolution.y);
+    glUniform1i(uniforms.windowMode, 1);
+    glUniform2f(uniforms.windowSize, size.x, size.y);
+    glUniform2f(uniforms.screenPos, pos.x, pos.y);
+    glUniform2f(uniforms.resolution, resolution.x, resolution.y);
+
+    // окно/уровень, гамма и палитра — во фрагментном шейдере, без перезаливки текстуры
+    float halfWidth = displaySettings.width * 0.5f;
+    bool useColormap = colormapTypes[displaySettings.colormap] >= 0;
+    glUniform1f(uniforms.windowLow, displaySettings.level - halfWidth);
+    glUniform1f(uniforms.windowHigh, displaySettings.level + halfWidth);
+    glUniform1f(uniforms.gamma, displaySettings.gamma);
+    glUniform1i(uniforms.useColormap, useColormap ? 1 : 0);
+
+    if (useColormap) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_1D, colormapTextureID);
+        glActiveTexture(GL_TEXTURE0);
+    }
 
     glBindTexture(GL_TEXTURE_2D, textureID);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
@@ -321,26 +466,24 @@ void RenderStatistics() {
     ImGui::Text("Center Position: (%d, %d)", currentAnalysis.centerX, currentAnalysis.centerY);
     ImGui::Text("Circle Radius: %d pixels", currentAnalysis.radius);
     
+    const auto& poolStats = analysisContext.pool.GetStats();
+    
+    ImGui::Spacing();
+    ImGui::Text("Buffer Pool:");
+    ImGui::Separator();
+    
+    ImGui::Text("Buffers Requested: %zu", poolStats.acquired);
+    ImGui::Text("Allocations: %zu (reused %zu)", poolStats.allocated, poolStats.acquired - poolStats.allocated);
+    ImGui::Text("Pooled: %zu buffers, %.1f KB", poolStats.pooledBuffers, poolStats.pooledBytes / 1024.0);
+    ImGui::Text("Evicted: %zu", poolStats.evicted);
+    
     ImGui::EndChild();
     
     ImGui::PopStyleVar(2);
 }
 
 json GetAnalysisData() {
-    json data;
-    
-    if (!currentAnalysis.edgeProfile.empty()) {
-        data["edgeProfile"] = currentAnalysis.edgeProfile;
-        data["noiseProfile"] = currentAnalysis.noiseProfile;
-        data["signalMean"] = currentAnalysis.signalMean;
-        data["noiseStd"] = currentAnalysis.noiseStd;
-        data["cnr"] = currentAnalysis.cnr;
-        data["centerX"] = currentAnalysis.centerX;
-        data["centerY"] = currentAnalysis.centerY;
-        data["radius"] = currentAnalysis.radius;
-    }
-    
-    return data;
+    return AnalysisToJson(currentAnalysis);
 }
 
 void SwapImages()
@@ -349,54 +492,7 @@ void SwapImages()
     std::swap(textureIDPtrs[0], textureIDPtrs[1]);
 }
 
-cv::Mat SharpenFilter(const cv::Mat& from)
-{
-    // sharpen image using "unsharp mask" algorithm
-    cv::Mat blurred;
-    double sigma = 1, threshold = 5, amount = 1;
-    cv::GaussianBlur(from, blurred, cv::Size(), sigma, sigma);
-
-    cv::Mat lowContrastMask = cv::abs(from - blurred) < threshold;
-    cv::Mat sharpened = from * (1+amount) + blurred * (-amount);
-    from.copyTo(sharpened, lowContrastMask);
-
-    return sharpened;
-}
-cv::Mat GaussBlurFilter(const cv::Mat& from)
-{
-    cv::Mat blurred;
-    double sigma = 1;
-    cv::GaussianBlur(from, blurred, cv::Size(), sigma, sigma);
-
-    return blurred;
-}
-
-cv::Mat LaplaceOperator(const cv::Mat& from)
-{
-    int kernel_size = 3,
-        scale = 1,
-        delta = 0,
-        ddepth = CV_16S;
-
-    cv::Mat abs_dst, dst;
-    cv::GaussianBlur(from, dst, cv::Size(3, 3), 0, 0, cv::BORDER_DEFAULT);
-    cv::Laplacian(from, dst, ddepth, kernel_size, scale, delta, cv::BORDER_DEFAULT);
-
-    // converting back to CV_8U
-    cv::convertScaleAbs(dst, abs_dst);
-
-    return abs_dst;
-}
-
 void SaveImageToDisk(const cv::Mat& from, const char* path)
 {
-    cv::imwrite(path, from);
-}
-
-cv::Mat NoiseFilter(const cv::Mat& from)
-{
-    cv::Mat noise(from.size(), from.type());
-    cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(10));
-
-    return from + noise;
+    cv::imwrite(path, DisplayImage(from));
 }
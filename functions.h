@@ -2,24 +2,22 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <opencv2/opencv.hpp>
+#include <memory>
 #include <vector>
 #include <string>
-#include <nlohmann/json.hpp>
 
 #include <imgui.h>
 
-using json = nlohmann::json;
+#include "analysis.h"
+#include "image_loader.h"
 
-// Структура для результатов анализа
-struct ImageAnalysisResult {
-    std::vector<double> edgeProfile;
-    std::vector<double> noiseProfile;
-    double signalMean = 0.0;
-    double noiseStd = 0.0;
-    double cnr = 0.0;
-    int centerX = 0;
-    int centerY = 0;
-    int radius = 0;
+// Настройки отображения, применяются во фрагментном шейдере.
+// Уровень и ширина окна задаются в долях полного диапазона текстуры.
+struct DisplaySettings {
+    float level = 0.5f;
+    float width = 1.0f;
+    float gamma = 1.0f;
+    int colormap = 0; // индекс в списке палитр, 0 — оттенки серого
 };
 
 // Глобальные переменные
@@ -41,18 +39,28 @@ extern GLuint*& processedImageID;
 extern std::vector<float> responseFunction;
 extern std::string outputMessage;
 extern ImageAnalysisResult currentAnalysis;
+// Создаётся при первой загрузке файла — потоки предвыборки не нужны, пока папка не открыта
+extern std::unique_ptr<ImageFolderCache> imageFolder;
+extern AnalysisContext analysisContext;
 
 extern ImVec2 resolution;
+extern DisplaySettings displaySettings;
 
 // Функции
 void GenerateCustomCircle(int width, int height, int radius);
 void LoadImage();
+void LoadNextImage();
+void LoadPreviousImage();
+bool LoadFrameStack();
 void CalculateResponseFunction();
 void UpdateImageTexture(const cv::Mat& from, GLuint& textureID);
 void RenderImage(const cv::Mat& from, const GLuint& textureID, const char* title);
+void InitDisplayPipeline();
+void ShutdownDisplayPipeline();
+void UpdateColormap();
+void RenderDisplayControls();
 double CalculateNoiseLevel(const cv::Mat& image);
 double CalculateCNR(const cv::Mat& image, const cv::Rect& roi);
-ImageAnalysisResult AnalyzeImage(const cv::Mat& image, const cv::Point& center, int radius);
 void RenderAnalysisWindows();
 void RenderEdgeProfile();
 void RenderNoiseProfile();
@@ -61,9 +69,4 @@ json GetAnalysisData();
 
 void SwapImages();
 
-cv::Mat SharpenFilter(const cv::Mat& from);
-cv::Mat GaussBlurFilter(const cv::Mat& from);
-cv::Mat LaplaceOperator(const cv::Mat& from);
-cv::Mat NoiseFilter(const cv::Mat& from);
-
 void SaveImageToDisk(const cv::Mat& from, const char* path);
@@ -0,0 +1,282 @@
+#include "image_loader.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static bool IsImageFile(const fs::path& path) {
+    static const char* extensions[] = {
+        ".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff",
+        ".pgm", ".ppm", ".pbm", ".webp", ".jp2", ".exr", ".hdr"
+    };
+
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    return std::find(std::begin(extensions), std::end(extensions), ext) != std::end(extensions);
+}
+
+bool NaturalPathLess(const std::string& a, const std::string& b) {
+    size_t i = 0, j = 0;
+
+    while (i < a.size() && j < b.size()) {
+        bool digitA = std::isdigit(static_cast<unsigned char>(a[i])) != 0;
+        bool digitB = std::isdigit(static_cast<unsigned char>(b[j])) != 0;
+
+        if (!digitA || !digitB) {
+            if (a[i] != b[j]) return a[i] < b[j];
+            ++i;
+            ++j;
+            continue;
+        }
+
+        // Числа сравниваем по значению: без ведущих нулей длиннее — значит больше
+        size_t zerosA = i, zerosB = j;
+        while (zerosA < a.size() && a[zerosA] == '0') ++zerosA;
+        while (zerosB < b.size() && b[zerosB] == '0') ++zerosB;
+
+        size_t endA = zerosA, endB = zerosB;
+        while (endA < a.size() && std::isdigit(static_cast<unsigned char>(a[endA]))) ++endA;
+        while (endB < b.size() && std::isdigit(static_cast<unsigned char>(b[endB]))) ++endB;
+
+        if (endA - zerosA != endB - zerosB) return endA - zerosA < endB - zerosB;
+
+        int order = a.compare(zerosA, endA - zerosA, b, zerosB, endB - zerosB);
+        if (order != 0) return order < 0;
+
+        // Равные числа: "01" после "1", чтобы порядок оставался строгим
+        if (zerosA - i != zerosB - j) return zerosA - i < zerosB - j;
+
+        i = endA;
+        j = endB;
+    }
+
+    return a.size() - i < b.size() - j;
+}
+
+static size_t ImageBytes(const cv::Mat& image) {
+    return image.total() * image.elemSize();
+}
+
+ImageFolderCache::ImageFolderCache(size_t memoryLimitBytes, int prefetchRadius, unsigned threadCount)
+    : memoryLimit(memoryLimitBytes), radius(std::max(0, prefetchRadius))
+{
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ImageFolderCache::WorkerLoop, this);
+    }
+}
+
+ImageFolderCache::~ImageFolderCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    queueReady.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+bool ImageFolderCache::Open(const std::string& path, cv::Mat& out) {
+    std::error_code ec;
+    fs::path file = fs::absolute(path, ec);
+    if (ec) file = path;
+
+    std::vector<std::string> listing;
+    for (const auto& entry : fs::directory_iterator(file.parent_path(), ec)) {
+        if (entry.is_regular_file(ec) && IsImageFile(entry.path())) {
+            listing.push_back(entry.path().string());
+        }
+    }
+    std::sort(listing.begin(), listing.end(), NaturalPathLess);
+
+    // Файл может иметь нестандартное расширение — всё равно показываем его
+    auto it = std::find(listing.begin(), listing.end(), file.string());
+    if (it == listing.end()) {
+        it = listing.insert(std::upper_bound(listing.begin(), listing.end(), file.string(), NaturalPathLess),
+                            file.string());
+    }
+
+    size_t selected = static_cast<size_t>(it - listing.begin());
+
+    // Папку подменяем только если выбранный файл действительно открылся,
+    // иначе остаёмся на прежнем изображении
+    cv::Mat image = Get(listing[selected]);
+    if (image.empty()) {
+        failedPath = listing[selected];
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+    }
+    files = std::move(listing);
+    position = selected;
+    Prefetch(position);
+
+    out = image;
+    return true;
+}
+
+bool ImageFolderCache::Next(cv::Mat& out) {
+    return Step(+1, out);
+}
+
+bool ImageFolderCache::Previous(cv::Mat& out) {
+    return Step(-1, out);
+}
+
+bool ImageFolderCache::HasNext() const {
+    return position + 1 < files.size();
+}
+
+bool ImageFolderCache::HasPrevious() const {
+    return !files.empty() && position > 0;
+}
+
+const std::string& ImageFolderCache::CurrentPath() const {
+    static const std::string empty;
+    return files.empty() ? empty : files[position];
+}
+
+size_t ImageFolderCache::CachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cachedBytes;
+}
+
+bool ImageFolderCache::Step(int direction, cv::Mat& out) {
+    size_t idx = position;
+
+    // Нечитаемые файлы пропускаем; позиция сдвигается только на успешно декодированный
+    while (direction > 0 ? idx + 1 < files.size() : idx > 0) {
+        idx = (direction > 0) ? idx + 1 : idx - 1;
+
+        cv::Mat image = Get(files[idx]);
+        if (image.empty()) {
+            failedPath = files[idx];
+            continue;
+        }
+
+        position = idx;
+        Prefetch(idx);
+
+        out = image;
+        return true;
+    }
+
+    return false;
+}
+
+cv::Mat ImageFolderCache::Get(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Если файл уже декодируется фоновым потоком — дожидаемся его
+    decoded.wait(lock, [&] { return inFlight.count(path) == 0; });
+
+    auto it = index.find(path);
+    if (it != index.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->second;
+    }
+
+    // Промах кэша: декодируем сами, не дожидаясь очереди
+    queue.erase(std::remove(queue.begin(), queue.end(), path), queue.end());
+    inFlight.insert(path);
+    lock.unlock();
+
+    cv::Mat image = Decode(path);
+
+    lock.lock();
+    Insert(path, image);
+    inFlight.erase(path);
+    decoded.notify_all();
+
+    return image;
+}
+
+void ImageFolderCache::Prefetch(size_t idx) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Старые заявки больше не актуальны — соседи сменились
+        queue.clear();
+
+        for (int d = 1; d <= radius; ++d) {
+            size_t candidates[2] = {idx + d, idx - d};
+            bool valid[2] = {idx + d < files.size(), idx >= static_cast<size_t>(d)};
+
+            for (int k = 0; k < 2; ++k) {
+                if (!valid[k]) continue;
+
+                const std::string& path = files[candidates[k]];
+                if (index.count(path) || inFlight.count(path)) continue;
+                queue.push_back(path);
+            }
+        }
+    }
+    queueReady.notify_all();
+}
+
+void ImageFolderCache::Insert(const std::string& path, const cv::Mat& image) {
+    if (image.empty()) return;
+
+    auto it = index.find(path);
+    if (it != index.end()) {
+        cachedBytes -= ImageBytes(it->second->second);
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    lru.emplace_front(path, image);
+    index[path] = lru.begin();
+    cachedBytes += ImageBytes(image);
+
+    EvictLocked();
+}
+
+void ImageFolderCache::EvictLocked() {
+    // Последний элемент не вытесняем, даже если он один больше лимита
+    while (cachedBytes > memoryLimit && lru.size() > 1) {
+        cachedBytes -= ImageBytes(lru.back().second);
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+void ImageFolderCache::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        queueReady.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (stopping) return;
+
+        std::string path = std::move(queue.front());
+        queue.pop_front();
+
+        if (index.count(path) || inFlight.count(path)) continue;
+
+        inFlight.insert(path);
+        lock.unlock();
+
+        cv::Mat image = Decode(path);
+
+        lock.lock();
+        Insert(path, image);
+        inFlight.erase(path);
+        decoded.notify_all();
+    }
+}
+
+cv::Mat ImageFolderCache::Decode(const std::string& path) {
+    // 16-битные снимки храним как есть: слабые края видны только в полной разрядности
+    return cv::imread(path, cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH);
+}
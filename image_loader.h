@@ -0,0 +1,83 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Навигация по изображениям в папке загруженного файла.
+// Соседние файлы декодируются заранее пулом потоков в LRU-кэш
+// с ограничением по памяти, так что переключение кадров мгновенное.
+// Изображения декодируются в исходной разрядности (8 или 16 бит).
+// Возвращаемые cv::Mat разделяют данные с кэшем — изменять их на месте нельзя.
+class ImageFolderCache {
+public:
+    explicit ImageFolderCache(size_t memoryLimitBytes = size_t(512) << 20,
+                              int prefetchRadius = 3,
+                              unsigned threadCount = 0);
+    ~ImageFolderCache();
+
+    ImageFolderCache(const ImageFolderCache&) = delete;
+    ImageFolderCache& operator=(const ImageFolderCache&) = delete;
+
+    // Сканирует папку файла и делает его текущим.
+    // Если файл не декодируется, прежняя папка и позиция сохраняются.
+    bool Open(const std::string& path, cv::Mat& out);
+    // Переход к соседнему файлу; нечитаемые файлы пропускаются.
+    // false — дальше файлов нет или ни один из оставшихся не прочитался (см. FailedPath)
+    bool Next(cv::Mat& out);
+    bool Previous(cv::Mat& out);
+    bool HasNext() const;
+    bool HasPrevious() const;
+
+    bool IsOpen() const { return !files.empty(); }
+    size_t Position() const { return position; }
+    size_t Count() const { return files.size(); }
+    const std::string& CurrentPath() const;
+    // Последний файл, который не удалось декодировать
+    const std::string& FailedPath() const { return failedPath; }
+
+    size_t CachedBytes() const;
+
+private:
+    using Entry = std::pair<std::string, cv::Mat>;
+
+    bool Step(int direction, cv::Mat& out);
+    cv::Mat Get(const std::string& path);
+    void Prefetch(size_t index);
+    void Insert(const std::string& path, const cv::Mat& image);
+    void EvictLocked();
+    void WorkerLoop();
+
+    static cv::Mat Decode(const std::string& path);
+
+    std::vector<std::string> files;
+    size_t position = 0;
+    std::string failedPath;
+
+    size_t memoryLimit;
+    int radius;
+
+    mutable std::mutex mutex;
+    std::condition_variable queueReady;
+    std::condition_variable decoded;
+
+    // LRU: начало списка — самые свежие записи
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t cachedBytes = 0;
+
+    std::deque<std::string> queue;
+    std::unordered_set<std::string> inFlight;
+
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+// Порядок имён файлов как у человека: "frame2" раньше "frame10"
+bool NaturalPathLess(const std::string& a, const std::string& b);
@@ -11,6 +11,7 @@
 #include <sstream>
 #include "functions.h"
 #include "tinyfiledialogs.h"
+#include "service.h"
 
 // Глобальные переменные
 GLFWwindow* window;
@@ -128,7 +129,13 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
     return progID;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Режим демона: без окна, анализ по запросам через Unix socket
+    ServiceOptions serviceOptions;
+    if(ParseServiceOptions(argc, argv, serviceOptions)) {
+        return RunAnalysisService(serviceOptions);
+    }
+
     // Инициализация GLFW
     if(!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -184,6 +191,7 @@ int main() {
         std::cerr << "Failed to load shaders" << std::endl;
         return -1;
     }
+    InitDisplayPipeline();
 
     // Создание вершинных данных
     float vertices[] = {
@@ -209,8 +217,12 @@ int main() {
     static int imageHeight = 300;
     static int circleRadius = 100;
 
-    // Установка псевдогенератора случайных чисел
-    cv::theRNG().state = cv::getTickCount();
+    // Параметры шума; seed задаётся явно, чтобы результат был воспроизводим
+    static int noiseModel = 0;
+    static float noiseSigma = 10.0f;
+    static float noiseQuanta = 1.0f;
+    static int noiseSeed = 0;
+    static bool advanceSeed = true;
 
     // Главный цикл
     while(!glfwWindowShouldClose(window)) {
@@ -244,15 +256,44 @@ int main() {
             currentImageRefresh = true;
         }
 
+        if(imageFolder && imageFolder->IsOpen()) {
+            if(ImGui::Button("< Prev", ImVec2(96, 30))) {
+                LoadPreviousImage();
+                currentImageRefresh = true;
+            }
+            ImGui::SameLine();
+            if(ImGui::Button("Next >", ImVec2(96, 30))) {
+                LoadNextImage();
+                currentImageRefresh = true;
+            }
+            ImGui::Text("Image %zu / %zu", imageFolder->Position() + 1, imageFolder->Count());
+        }
+
         static std::string enhancedImageTitle = "Enhanced";
 
+        if(ImGui::Button("Load Frame Stack", ImVec2(200, 30))) {
+            if(LoadFrameStack()) {
+                currentImageRefresh = true;
+                processedImageRefresh = true;
+                calculatedResponse = !responseFunction.empty();
+                enhancedImageTitle = "Noise StdDev Map";
+            }
+        }
+
         if(ImGui::Button("Calculate Response", ImVec2(200, 30))) {
             CalculateResponseFunction();
-            calculatedResponse = true;
+            calculatedResponse = !responseFunction.empty();
             processedImageRefresh = true;
             enhancedImageTitle = "Detected Circle";
         }
 
+        ImGui::Text("Noise Parameters:");
+        ImGui::Combo("Model", &noiseModel, "Gaussian\0Poisson\0Mixed\0");
+        ImGui::SliderFloat("Sigma", &noiseSigma, 0.0f, 50.0f);
+        ImGui::SliderFloat("Quanta per level", &noiseQuanta, 0.05f, 20.0f, "%.2f");
+        ImGui::InputInt("Seed", &noiseSeed);
+        ImGui::Checkbox("Advance seed", &advanceSeed);
+
         static bool applyToSource = true;
         ImGui::Checkbox("Apply Enhancement to Source", &applyToSource);
 
@@ -267,11 +308,11 @@ int main() {
 
                 outputMessage = std::string("Applied ") + title;
                 if(applyToSource) {
-                    *currentImage = enhance_functor(*currentImage);
+                    *currentImage = enhance_functor(*currentImage, analysisContext);
                     UpdateImageTexture(*currentImage, *currentImageID);
                     currentImageRefresh = true;
                 } else {
-                    *processedImage = enhance_functor(*currentImage);
+                    *processedImage = enhance_functor(*currentImage, analysisContext);
                     UpdateImageTexture(*processedImage, *processedImageID);
                     processedImageRefresh = true;
                     enhancedImageTitle = outputMessage;
@@ -282,7 +323,18 @@ int main() {
 
         EnhancementButton("Sharpen filter", SharpenFilter);
         EnhancementButton("Gauss Blur", GaussBlurFilter);
-        EnhancementButton("Noise Addition", NoiseFilter);
+        EnhancementButton("Noise Addition", [&](const cv::Mat& from, AnalysisContext&) {
+            NoiseParams noiseParams;
+            noiseParams.model = static_cast<NoiseModel>(noiseModel);
+            noiseParams.sigma = noiseSigma;
+            noiseParams.quantaPerLevel = noiseQuanta;
+            noiseParams.seed = static_cast<uint64_t>(noiseSeed);
+
+            // Следующее нажатие даст новую, но тоже воспроизводимую реализацию
+            if(advanceSeed) ++noiseSeed;
+
+            return NoiseFilter(from, noiseParams);
+        });
         EnhancementButton("Edge Enhancement", LaplaceOperator);
 
         [&](){
@@ -326,6 +378,9 @@ int main() {
             }
         }();
 
+        ImGui::Separator();
+        RenderDisplayControls();
+
         ImGui::Separator();
         ImGui::TextWrapped("%s", outputMessage.c_str());
         ImGui::End();
@@ -384,6 +439,7 @@ int main() {
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    ShutdownDisplayPipeline();
     glDeleteVertexArrays(1, &vao);
     glDeleteBuffers(1, &vbo);
     glDeleteProgram(programID);
@@ -0,0 +1,264 @@
+#include "noise.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Сколько вызовов Philox считается за раз; SoA-массивы такой длины
+// компилятор разворачивает в векторные инструкции
+constexpr int lanes = 8;
+
+// Константы Philox4x32 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+constexpr uint32_t philoxM0 = 0xD2511F53u;
+constexpr uint32_t philoxM1 = 0xCD9E8D57u;
+constexpr uint32_t philoxW0 = 0x9E3779B9u;
+constexpr uint32_t philoxW1 = 0xBB67AE85u;
+
+// Третье слово счётчика Philox разводит независимые потоки случайных чисел
+constexpr uint32_t gaussianStream = 0;      // счётчик — номер четвёрки элементов
+constexpr uint32_t poissonStream = 1;       // счётчик — номер пары элементов
+constexpr uint32_t poissonRetryStream = 2;  // счётчик — индекс элемента, + номер повтора
+
+// Philox4x32-10 для счётчиков base .. base + count - 1
+template<int count>
+inline void Philox(uint64_t base, uint64_t seed, uint32_t stream, uint32_t out[4][count]) {
+    uint32_t c0[count], c1[count], c2[count], c3[count];
+    for (int l = 0; l < count; ++l) {
+        uint64_t counter = base + static_cast<uint64_t>(l);
+        c0[l] = static_cast<uint32_t>(counter);
+        c1[l] = static_cast<uint32_t>(counter >> 32);
+        c2[l] = stream;
+        c3[l] = 0;
+    }
+
+    uint32_t k0 = static_cast<uint32_t>(seed);
+    uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+
+    for (int round = 0; round < 10; ++round) {
+        for (int l = 0; l < count; ++l) {
+            uint64_t p0 = static_cast<uint64_t>(philoxM0) * c0[l];
+            uint64_t p1 = static_cast<uint64_t>(philoxM1) * c2[l];
+
+            uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+            uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+
+            c1[l] = static_cast<uint32_t>(p1);
+            c3[l] = static_cast<uint32_t>(p0);
+            c0[l] = n0;
+            c2[l] = n2;
+        }
+        k0 += philoxW0;
+        k1 += philoxW1;
+    }
+
+    for (int l = 0; l < count; ++l) {
+        out[0][l] = c0[l];
+        out[1][l] = c1[l];
+        out[2][l] = c2[l];
+        out[3][l] = c3[l];
+    }
+}
+
+// Равномерное в открытом интервале (0, 1), чтобы log() не получил ноль
+inline double ToUniform(uint32_t u) {
+    return (static_cast<double>(u) + 0.5) * (1.0 / 4294967296.0);
+}
+
+// Бокс-Мюллер: из двух равномерных — два независимых нормальных, используются оба
+inline void BoxMuller(uint32_t a, uint32_t b, double& z0, double& z1) {
+    double r = std::sqrt(-2.0 * std::log(ToUniform(a)));
+    double phi = 2.0 * CV_PI * ToUniform(b);
+    z0 = r * std::cos(phi);
+    z1 = r * std::sin(phi);
+}
+
+// log(k!) через ряд Стирлинга для log Г(k + 1); std::lgamma пишет в глобальный signgam
+double LogFactorial(double k) {
+    static const double coefficients[10] = {
+        8.333333333333333e-02, -2.777777777777778e-03, 7.936507936507937e-04,
+        -5.952380952380952e-04, 8.417508417508418e-04, -1.917526917526918e-03,
+        6.410256410256410e-03, -2.955065359477124e-02, 1.796443723688307e-01,
+        -1.39243221690590e+00
+    };
+
+    double x = k + 1;
+    if (x == 1 || x == 2) return 0;
+
+    // Ряд точен для больших аргументов: малые сдвигаем вверх и потом поправляем
+    int shift = (x < 7) ? static_cast<int>(7 - x) : 0;
+    double x0 = x + shift;
+    double x2 = 1.0 / (x0 * x0);
+
+    double series = coefficients[9];
+    for (int i = 8; i >= 0; --i) {
+        series = series * x2 + coefficients[i];
+    }
+    double result = series / x0 + 0.5 * std::log(2 * CV_PI) + (x0 - 0.5) * std::log(x0) - x0;
+
+    for (int i = 0; i < shift; ++i) {
+        x0 -= 1;
+        result -= std::log(x0);
+    }
+    return result;
+}
+
+// Пуассон без приближений: инверсия для малых lambda и метод PTRS
+// (Hörmann, "The transformed rejection method for generating Poisson random variables") для больших.
+// a, b — первая попытка; редкие повторные попытки берут числа из отдельного потока Philox элемента.
+double SamplePoisson(double lambda, uint32_t a, uint32_t b, uint64_t element, uint64_t seed) {
+    if (lambda <= 0) return 0;
+
+    if (lambda < 10) {
+        double u = ToUniform(a);
+        double p = std::exp(-lambda);
+        double cdf = p;
+        int k = 0;
+        while (u > cdf && k < 256) {
+            ++k;
+            p *= lambda / k;
+            cdf += p;
+        }
+        return k;
+    }
+
+    const double sqrtLambda = std::sqrt(lambda);
+    const double logLambda = std::log(lambda);
+    const double bb = 0.931 + 2.53 * sqrtLambda;
+    const double aa = -0.059 + 0.02483 * bb;
+    const double invAlpha = 1.1239 + 1.1328 / (bb - 3.4);
+    const double vr = 0.9277 - 3.6224 / (bb - 2);
+
+    uint32_t retry[4][1];
+    for (uint32_t attempt = 0; ; ++attempt) {
+        if (attempt > 0) {
+            // Одного вызова хватает на две попытки
+            if (attempt % 2 == 1) {
+                Philox<1>(element, seed, poissonRetryStream + attempt / 2, retry);
+            }
+            a = retry[(attempt % 2) * 2][0];
+            b = retry[(attempt % 2) * 2 + 1][0];
+        }
+
+        double u = ToUniform(a) - 0.5;
+        double v = ToUniform(b);
+        double us = 0.5 - std::abs(u);
+        double k = std::floor((2 * aa / us + bb) * u + lambda + 0.43);
+
+        if (us >= 0.07 && v <= vr) return k;
+        if (k < 0 || (us < 0.013 && v > us)) continue;
+
+        if (std::log(v) + std::log(invAlpha) - std::log(aa / (us * us) + bb) <=
+            -lambda + k * logLambda - LogFactorial(k)) {
+            return k;
+        }
+    }
+}
+
+// Нормальные величины для строки: один вызов Philox на четыре элемента
+void GaussianRow(uint64_t row, int width, uint64_t seed, double* z) {
+    const int quads = (width + 3) / 4;
+    const uint64_t base = row * static_cast<uint64_t>(quads);
+
+    uint32_t random[4][lanes];
+    double values[4];
+
+    for (int q = 0; q < quads; q += lanes) {
+        Philox<lanes>(base + static_cast<uint64_t>(q), seed, gaussianStream, random);
+
+        int count = std::min(lanes, quads - q);
+        for (int l = 0; l < count; ++l) {
+            BoxMuller(random[0][l], random[1][l], values[0], values[1]);
+            BoxMuller(random[2][l], random[3][l], values[2], values[3]);
+
+            int x = 4 * (q + l);
+            for (int i = 0; i < 4 && x + i < width; ++i) {
+                z[x + i] = values[i];
+            }
+        }
+    }
+}
+
+// Число квантов для строки: один вызов Philox на пару элементов, по два слова на элемент
+template<typename T>
+void PoissonRow(const T* in, uint64_t row, int width, double quanta, uint64_t seed, double* counts) {
+    const int pairs = (width + 1) / 2;
+    const uint64_t base = row * static_cast<uint64_t>(pairs);
+
+    uint32_t random[4][lanes];
+
+    for (int p = 0; p < pairs; p += lanes) {
+        Philox<lanes>(base + static_cast<uint64_t>(p), seed, poissonStream, random);
+
+        int count = std::min(lanes, pairs - p);
+        for (int l = 0; l < count; ++l) {
+            for (int i = 0; i < 2; ++i) {
+                int x = 2 * (p + l) + i;
+                if (x >= width) break;
+
+                uint64_t element = row * static_cast<uint64_t>(width) + static_cast<uint64_t>(x);
+                double lambda = static_cast<double>(in[x]) * quanta;
+                counts[x] = SamplePoisson(lambda, random[2 * i][l], random[2 * i + 1][l], element, seed);
+            }
+        }
+    }
+}
+
+template<typename T>
+void ApplyNoiseRows(const cv::Mat& src, cv::Mat& dst, const NoiseParams& params, const cv::Range& rows) {
+    const int width = src.cols * src.channels();
+    const double quanta = std::max(params.quantaPerLevel, 1e-6);
+
+    const bool gaussian = params.model != NoiseModel::Poisson;
+    const bool poisson = params.model != NoiseModel::Gaussian;
+
+    // Случайные величины строки считаются пачкой, буферы общие на полосу строк
+    std::vector<double> z(gaussian ? width : 0);
+    std::vector<double> counts(poisson ? width : 0);
+
+    for (int y = rows.start; y < rows.end; ++y) {
+        const T* in = src.ptr<T>(y);
+        T* out = dst.ptr<T>(y);
+
+        // Счётчики считаются от номера строки, от разбиения на потоки не зависят
+        if (gaussian) GaussianRow(static_cast<uint64_t>(y), width, params.seed, z.data());
+        if (poisson) PoissonRow(in, static_cast<uint64_t>(y), width, quanta, params.seed, counts.data());
+
+        for (int x = 0; x < width; ++x) {
+            double value = poisson ? counts[x] / quanta : static_cast<double>(in[x]);
+            if (gaussian) value += params.sigma * z[x];
+
+            out[x] = cv::saturate_cast<T>(value);
+        }
+    }
+}
+
+template<typename T>
+void ApplyNoise(const cv::Mat& src, cv::Mat& dst, const NoiseParams& params) {
+    // Полосы по 16 строк — достаточно крупно, чтобы не тратиться на планирование
+    double stripes = std::max(1.0, src.rows / 16.0);
+
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+        ApplyNoiseRows<T>(src, dst, params, rows);
+    }, stripes);
+}
+
+} // namespace
+
+cv::Mat AddNoise(const cv::Mat& from, const NoiseParams& params) {
+    if (from.empty()) return cv::Mat();
+
+    cv::Mat noisy(from.size(), from.type());
+
+    switch (from.depth()) {
+    case CV_8U:  ApplyNoise<uchar>(from, noisy, params); break;
+    case CV_16U: ApplyNoise<ushort>(from, noisy, params); break;
+    case CV_16S: ApplyNoise<short>(from, noisy, params); break;
+    case CV_32F: ApplyNoise<float>(from, noisy, params); break;
+    case CV_64F: ApplyNoise<double>(from, noisy, params); break;
+    default:
+        CV_Error(cv::Error::StsUnsupportedFormat, "AddNoise: unsupported image depth");
+    }
+
+    return noisy;
+}
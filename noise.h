@@ -0,0 +1,23 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+// Модели шума для синтеза тестовых изображений
+enum class NoiseModel {
+    Gaussian,   // аддитивный гауссов шум (электроника)
+    Poisson,    // квантовый шум, зависит от уровня сигнала; точное распределение при любом уровне
+    Mixed       // квантовый + гауссов
+};
+
+struct NoiseParams {
+    NoiseModel model = NoiseModel::Gaussian;
+    double sigma = 10.0;        // СКО гауссовой компоненты, в уровнях яркости
+    double quantaPerLevel = 1.0; // число квантов на один уровень яркости (Poisson)
+    uint64_t seed = 0;
+};
+
+// Добавляет шум в промежуточном представлении double и насыщает обратно в тип исходника.
+// Случайные числа берутся из счётного генератора Philox4x32-10: счётчик — номер группы элементов
+// строки (четвёрки для гауссова шума, пары для пуассоновского), ключ — seed.
+// Поэтому результат побитово воспроизводим при любом числе потоков.
+cv::Mat AddNoise(const cv::Mat& from, const NoiseParams& params);
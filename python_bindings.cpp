@@ -0,0 +1,207 @@
+// Python-модуль edge_response поверх EdgeResponseCore.
+// Входные массивы NumPy оборачиваются в cv::Mat без копирования, вычисления идут
+// с отпущенным GIL, а результаты (изображения и профили) отдаются как массивы NumPy,
+// которые владеют исходным буфером C++ через capsule — тоже без копирования.
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "analysis.h"
+
+namespace py = pybind11;
+
+namespace {
+
+// У каждого потока Python свой контекст — вызовы из разных потоков не мешают друг другу
+AnalysisContext& ThreadContext() {
+    thread_local AnalysisContext context;
+    return context;
+}
+
+int DepthOf(const py::array& array) {
+    if (py::isinstance<py::array_t<uint8_t>>(array))  return CV_8U;
+    if (py::isinstance<py::array_t<uint16_t>>(array)) return CV_16U;
+    if (py::isinstance<py::array_t<int16_t>>(array))  return CV_16S;
+    if (py::isinstance<py::array_t<float>>(array))    return CV_32F;
+    if (py::isinstance<py::array_t<double>>(array))   return CV_64F;
+    throw py::type_error("unsupported dtype, expected uint8, uint16, int16, float32 or float64");
+}
+
+py::dtype DtypeFromDepth(int depth) {
+    switch (depth) {
+    case CV_8U:  return py::dtype::of<uint8_t>();
+    case CV_16U: return py::dtype::of<uint16_t>();
+    case CV_16S: return py::dtype::of<int16_t>();
+    case CV_32F: return py::dtype::of<float>();
+    case CV_64F: return py::dtype::of<double>();
+    default:
+        throw py::type_error("unsupported image depth");
+    }
+}
+
+// Представление 2D-массива как cv::Mat без копирования.
+// Строки могут идти с произвольным шагом, но пиксели в строке должны лежать подряд.
+cv::Mat ArrayView(const py::array& array, bool requireUint8 = false) {
+    if (array.ndim() != 2) {
+        throw py::value_error("expected a 2D grayscale image");
+    }
+
+    int depth = DepthOf(array);
+    if (requireUint8 && depth != CV_8U) {
+        throw py::type_error("analysis expects a uint8 image");
+    }
+    if (array.strides(1) != array.itemsize() || array.strides(0) < 0) {
+        throw py::value_error("image rows must be contiguous; use numpy.ascontiguousarray");
+    }
+
+    return cv::Mat(static_cast<int>(array.shape(0)), static_cast<int>(array.shape(1)),
+                   CV_MAKETYPE(depth, 1), const_cast<void*>(array.data()),
+                   static_cast<size_t>(array.strides(0)));
+}
+
+// Отдаём cv::Mat в NumPy, capsule держит ссылку на данные
+py::array MatToArray(cv::Mat mat) {
+    if (mat.channels() != 1) {
+        throw py::value_error("only single-channel images are supported");
+    }
+
+    auto* owner = new cv::Mat(std::move(mat));
+    py::capsule capsule(owner, [](void* p) { delete static_cast<cv::Mat*>(p); });
+
+    return py::array(DtypeFromDepth(owner->depth()),
+                     {static_cast<py::ssize_t>(owner->rows), static_cast<py::ssize_t>(owner->cols)},
+                     {static_cast<py::ssize_t>(owner->step[0]), static_cast<py::ssize_t>(owner->elemSize())},
+                     owner->data, capsule);
+}
+
+template<typename T>
+py::array VectorToArray(std::vector<T>&& values) {
+    auto* owner = new std::vector<T>(std::move(values));
+    py::capsule capsule(owner, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+
+    return py::array_t<T>({static_cast<py::ssize_t>(owner->size())}, {static_cast<py::ssize_t>(sizeof(T))},
+                          owner->data(), capsule);
+}
+
+py::dict AnalysisToDict(ImageAnalysisResult&& analysis) {
+    py::dict data;
+    data["center_x"] = analysis.centerX;
+    data["center_y"] = analysis.centerY;
+    data["radius"] = analysis.radius;
+    data["signal_mean"] = analysis.signalMean;
+    data["noise_std"] = analysis.noiseStd;
+    data["cnr"] = analysis.cnr;
+    data["edge_profile"] = VectorToArray(std::move(analysis.edgeProfile));
+    data["noise_profile"] = VectorToArray(std::move(analysis.noiseProfile));
+    return data;
+}
+
+py::object DetectCirclePy(const py::array& image) {
+    cv::Mat view = ArrayView(image, true);
+    cv::Point center;
+    int radius = 0;
+    bool found;
+    {
+        py::gil_scoped_release release;
+        found = DetectCircle(ThreadContext(), view, center, radius);
+    }
+
+    if (!found) return py::none();
+    return py::make_tuple(center.x, center.y, radius);
+}
+
+py::dict AnalyzeImagePy(const py::array& image, std::pair<int, int> center, int radius) {
+    cv::Mat view = ArrayView(image, true);
+    ImageAnalysisResult analysis;
+    {
+        py::gil_scoped_release release;
+        AnalyzeImage(ThreadContext(), view, cv::Point(center.first, center.second), radius, analysis);
+    }
+    return AnalysisToDict(std::move(analysis));
+}
+
+py::object CalculateEdgeResponsePy(const py::array& image) {
+    cv::Mat view = ArrayView(image, true);
+    ImageAnalysisResult analysis;
+    std::vector<float> responseFunction;
+    bool found;
+    {
+        py::gil_scoped_release release;
+        found = CalculateEdgeResponse(ThreadContext(), view, analysis, responseFunction);
+    }
+
+    if (!found) return py::none();
+
+    py::dict data = AnalysisToDict(std::move(analysis));
+    data["response_function"] = VectorToArray(std::move(responseFunction));
+    return std::move(data);
+}
+
+template<cv::Mat (*Filter)(const cv::Mat&, AnalysisContext&)>
+py::array FilterPy(const py::array& image) {
+    cv::Mat view = ArrayView(image);
+    cv::Mat filtered;
+    {
+        py::gil_scoped_release release;
+        filtered = Filter(view, ThreadContext());
+    }
+    return MatToArray(std::move(filtered));
+}
+
+py::array AddNoisePy(const py::array& image, const std::string& model, double sigma,
+                     double quantaPerLevel, uint64_t seed) {
+    NoiseParams params;
+    if (model == "gaussian")      params.model = NoiseModel::Gaussian;
+    else if (model == "poisson")  params.model = NoiseModel::Poisson;
+    else if (model == "mixed")    params.model = NoiseModel::Mixed;
+    else throw py::value_error("model must be 'gaussian', 'poisson' or 'mixed'");
+
+    params.sigma = sigma;
+    params.quantaPerLevel = quantaPerLevel;
+    params.seed = seed;
+
+    cv::Mat view = ArrayView(image);
+    cv::Mat noisy;
+    {
+        py::gil_scoped_release release;
+        noisy = NoiseFilter(view, params);
+    }
+    return MatToArray(std::move(noisy));
+}
+
+py::array GenerateCirclePy(int width, int height, int radius) {
+    if (width <= 0 || height <= 0) {
+        throw py::value_error("width and height must be positive");
+    }
+
+    cv::Mat image;
+    {
+        py::gil_scoped_release release;
+        image = GenerateCircleImage(width, height, radius);
+    }
+    return MatToArray(std::move(image));
+}
+
+} // namespace
+
+PYBIND11_MODULE(edge_response, m) {
+    m.doc() = "Edge response analysis of circular phantoms";
+
+    m.def("detect_circle", &DetectCirclePy, py::arg("image"),
+          "Detect the circle; returns (center_x, center_y, radius) or None");
+    m.def("analyze_image", &AnalyzeImagePy, py::arg("image"), py::arg("center"), py::arg("radius"),
+          "Edge and noise profiles around a known circle");
+    m.def("calculate_edge_response", &CalculateEdgeResponsePy, py::arg("image"),
+          "Detection + analysis + response function; returns a dict or None");
+
+    m.def("sharpen", &FilterPy<SharpenFilter>, py::arg("image"));
+    m.def("gauss_blur", &FilterPy<GaussBlurFilter>, py::arg("image"));
+    m.def("laplace", &FilterPy<LaplaceOperator>, py::arg("image"),
+          "Absolute Laplacian; uint8 for uint8 input, float32 (float64 for float64) otherwise");
+    m.def("add_noise", &AddNoisePy, py::arg("image"), py::arg("model") = "gaussian",
+          py::arg("sigma") = 10.0, py::arg("quanta_per_level") = 1.0, py::arg("seed") = 0,
+          "Reproducible noise from a counter-based RNG");
+
+    m.def("generate_circle", &GenerateCirclePy, py::arg("width"), py::arg("height"), py::arg("radius"),
+          "Synthetic blurred circle phantom");
+}
@@ -0,0 +1,437 @@
+#include "service.h"
+#include "analysis.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+bool ParseServiceOptions(int argc, char** argv, ServiceOptions& options) {
+    bool serve = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc) && std::strncmp(argv[i + 1], "--", 2) != 0;
+
+        if (arg == "--serve") {
+            serve = true;
+            if (hasValue) options.socketPath = argv[++i];
+        } else if (arg == "--workers" && hasValue) {
+            options.workerCount = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--batch" && hasValue) {
+            options.batchSize = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+    }
+
+    return serve;
+}
+
+#ifdef _WIN32
+
+int RunAnalysisService(const ServiceOptions&) {
+    std::cerr << "Service mode requires Unix domain sockets and is not supported on Windows" << std::endl;
+    return 1;
+}
+
+#else
+
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Ограничения на входные данные, чтобы кривой клиент не уронил сервер
+constexpr size_t maxLineLength = 4096;
+constexpr int maxImageSide = 16384;
+
+std::string DefaultSocketPath() {
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir) {
+        return std::string(runtimeDir) + "/edge-response.sock";
+    }
+    return "/tmp/edge-response-" + std::to_string(getuid()) + ".sock";
+}
+
+// Удаляет оставшийся от прошлого запуска сокет. Любой другой файл по этому пути
+// не трогаем — иначе --serve ~/file молча удалил бы его
+bool RemoveStaleSocket(const std::string& path) {
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        errno = EEXIST;
+        return false;
+    }
+    return unlink(path.c_str()) == 0;
+}
+
+struct Request {
+    std::string path;
+    cv::Mat image;
+};
+
+std::string ErrorReply(const std::string& message) {
+    json reply;
+    reply["status"] = "error";
+    reply["message"] = message;
+    return reply.dump();
+}
+
+// Детекция круга + анализ, то же что CalculateResponseFunction, но без глобального состояния
+std::string ProcessRequest(const Request& request, AnalysisContext& context) {
+    cv::Mat image = request.image;
+    if (image.empty()) {
+        image = cv::imread(request.path, cv::IMREAD_GRAYSCALE);
+    }
+    if (image.empty()) {
+        return ErrorReply("Failed to load image");
+    }
+
+    cv::Point center;
+    int radius = 0;
+    if (!DetectCircle(context, image, center, radius)) {
+        return ErrorReply("No circles detected");
+    }
+
+    ImageAnalysisResult analysis;
+    AnalyzeImage(context, image, center, radius, analysis);
+
+    json reply = AnalysisToJson(analysis);
+    reply["status"] = "ok";
+    return reply.dump();
+}
+
+std::future<std::string> ReadyReply(std::string reply) {
+    std::promise<std::string> promise;
+    promise.set_value(std::move(reply));
+    return promise.get_future();
+}
+
+// Фиксированный пул воркеров; каждый забирает из очереди сразу пачку заявок
+class WorkerPool {
+public:
+    WorkerPool(unsigned count, size_t batch)
+        : batchSize(std::max<size_t>(1, batch)), workerCount(std::max(1u, count)) {
+        for (unsigned i = 0; i < workerCount; ++i) {
+            threads.emplace_back(&WorkerPool::Loop, this);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::future<std::string> Submit(Request request) {
+        Job job{std::move(request), {}};
+        auto future = job.reply.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        ready.notify_one();
+        return future;
+    }
+
+private:
+    struct Job {
+        Request request;
+        std::promise<std::string> reply;
+    };
+
+    void Loop() {
+        // Свой контекст на воркер: буферы переиспользуются между заявками
+        AnalysisContext context;
+        std::vector<Job> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            ready.wait(lock, [&] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+
+            // Не забираем больше своей доли, чтобы соседние воркеры не простаивали
+            size_t share = std::max<size_t>(1, jobs.size() / workerCount);
+            size_t take = std::min(batchSize, share);
+            for (size_t i = 0; i < take; ++i) {
+                batch.push_back(std::move(jobs.front()));
+                jobs.pop_front();
+            }
+            lock.unlock();
+
+            for (auto& job : batch) {
+                try {
+                    job.reply.set_value(ProcessRequest(job.request, context));
+                } catch (const std::exception& e) {
+                    job.reply.set_value(ErrorReply(e.what()));
+                }
+            }
+            batch.clear();
+
+            lock.lock();
+        }
+    }
+
+    size_t batchSize;
+    unsigned workerCount;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Job> jobs;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+};
+
+// Буферизованное чтение строк и бинарных блоков из сокета
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {}
+
+    bool ReadLine(std::string& line) {
+        size_t end;
+        while ((end = buffer.find('\n')) == std::string::npos) {
+            if (buffer.size() > maxLineLength || !Fill()) return false;
+        }
+
+        line.assign(buffer, 0, end);
+        buffer.erase(0, end + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    }
+
+    bool ReadBytes(uchar* dst, size_t count) {
+        size_t fromBuffer = std::min(count, buffer.size());
+        std::memcpy(dst, buffer.data(), fromBuffer);
+        buffer.erase(0, fromBuffer);
+
+        // Остаток читаем сразу в память изображения, минуя буфер
+        for (size_t done = fromBuffer; done < count;) {
+            ssize_t n = recv(fd, dst + done, count - done, 0);
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Есть ли уже пришедшие, но ещё не прочитанные данные
+    bool HasPending() {
+        if (!buffer.empty()) return true;
+        pollfd p{fd, POLLIN, 0};
+        return poll(&p, 1, 0) > 0 && (p.revents & POLLIN);
+    }
+
+    bool WriteLine(const std::string& line) {
+        std::string data = line + '\n';
+        for (size_t done = 0; done < data.size();) {
+            ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+private:
+    bool Fill() {
+        char chunk[4096];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd;
+    std::string buffer;
+};
+
+enum class ReadStatus { Ok, Invalid, Fatal, Closed };
+
+ReadStatus ReadRequest(Connection& connection, Request& request, std::string& error) {
+    std::string line;
+    if (!connection.ReadLine(line)) return ReadStatus::Closed;
+
+    if (line.rfind("PATH ", 0) == 0) {
+        request.path = line.substr(5);
+        return ReadStatus::Ok;
+    }
+
+    if (line.rfind("RAW ", 0) == 0) {
+        int width = 0, height = 0;
+        if (std::sscanf(line.c_str() + 4, "%d %d", &width, &height) != 2 ||
+            width <= 0 || height <= 0 || width > maxImageSide || height > maxImageSide) {
+            // Размер блока неизвестен — дальше поток не разобрать
+            error = "Invalid RAW dimensions";
+            return ReadStatus::Fatal;
+        }
+
+        request.image.create(height, width, CV_8UC1);
+        if (!connection.ReadBytes(request.image.ptr(), request.image.total())) return ReadStatus::Closed;
+        return ReadStatus::Ok;
+    }
+
+    error = "Unknown command";
+    return ReadStatus::Invalid;
+}
+
+void ServeConnection(int fd, WorkerPool& pool, size_t batchSize) {
+    Connection connection(fd);
+    std::vector<std::future<std::string>> pending;
+    bool open = true;
+
+    while (open) {
+        // Ждём хотя бы одну заявку, затем добираем уже пришедшие — до размера пачки
+        do {
+            Request request;
+            std::string error;
+            ReadStatus status = ReadRequest(connection, request, error);
+
+            if (status == ReadStatus::Ok) {
+                pending.push_back(pool.Submit(std::move(request)));
+            } else {
+                if (status != ReadStatus::Closed) pending.push_back(ReadyReply(ErrorReply(error)));
+                if (status != ReadStatus::Invalid) open = false;
+                if (!open) break;
+            }
+        } while (pending.size() < batchSize && connection.HasPending());
+
+        for (auto& reply : pending) {
+            if (!connection.WriteLine(reply.get())) {
+                open = false;
+                break;
+            }
+        }
+        pending.clear();
+    }
+}
+
+std::atomic<bool> stopRequested{false};
+
+void HandleStopSignal(int) {
+    stopRequested = true;
+}
+
+struct ConnectionSlot {
+    int fd;
+    std::shared_ptr<std::atomic<bool>> done;
+    std::thread thread;
+};
+
+} // namespace
+
+int RunAnalysisService(const ServiceOptions& options) {
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, HandleStopSignal);
+    std::signal(SIGTERM, HandleStopSignal);
+
+    const std::string socketPath = options.socketPath.empty() ? DefaultSocketPath() : options.socketPath;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path is too long: " << socketPath << std::endl;
+        return 1;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    if (!RemoveStaleSocket(socketPath)) {
+        int error = errno;
+        std::cerr << "Cannot use " << socketPath << ": "
+                  << (error == EEXIST ? "file exists and is not a socket" : std::strerror(error)) << std::endl;
+        close(listenFd);
+        return 1;
+    }
+
+    // Сокет сразу создаётся с правами 0600, без окна, в котором к нему мог бы подключиться кто-то ещё
+    mode_t previousMask = umask(0177);
+    bool bound = bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(previousMask);
+
+    if (!bound || chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0) {
+        std::cerr << "Failed to listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listenFd);
+        if (bound) RemoveStaleSocket(socketPath);
+        return 1;
+    }
+
+    unsigned workerCount = options.workerCount;
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Параллелим по заявкам, внутренние потоки OpenCV только мешали бы
+    cv::setNumThreads(1);
+
+    std::list<ConnectionSlot> connections;
+    {
+        WorkerPool pool(workerCount, options.batchSize);
+        std::cout << "Listening on " << socketPath << " with " << workerCount << " workers" << std::endl;
+
+        while (!stopRequested) {
+            // Подчищаем завершившиеся соединения
+            for (auto it = connections.begin(); it != connections.end();) {
+                if (*it->done) {
+                    it->thread.join();
+                    close(it->fd);
+                    it = connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            pollfd p{listenFd, POLLIN, 0};
+            if (poll(&p, 1, 200) <= 0) continue;
+
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            std::thread thread([fd, done, &pool, &options] {
+                ServeConnection(fd, pool, options.batchSize);
+                *done = true;
+            });
+            connections.push_back({fd, done, std::move(thread)});
+        }
+
+        // Будим соединения, висящие в recv, и дожидаемся их до остановки пула
+        for (auto& connection : connections) {
+            shutdown(connection.fd, SHUT_RDWR);
+        }
+        for (auto& connection : connections) {
+            connection.thread.join();
+            close(connection.fd);
+        }
+    }
+
+    close(listenFd);
+    RemoveStaleSocket(socketPath);
+    std::cout << "Service stopped" << std::endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Параметры режима демона (--serve)
+struct ServiceOptions {
+    // Пусто — $XDG_RUNTIME_DIR/edge-response.sock, а без него /tmp/edge-response-<uid>.sock.
+    // Сокет доступен только владельцу (0600): через него можно читать любые файлы с правами демона.
+    std::string socketPath;
+    unsigned workerCount = 0;   // 0 — по числу ядер
+    size_t batchSize = 8;       // сколько заявок воркер забирает из очереди за раз
+};
+
+// Протокол — построчный, поверх Unix domain socket:
+//   PATH <путь к файлу>\n
+//   RAW <ширина> <высота>\n<ширина*высота байт 8-битного ч/б изображения>
+// На каждую заявку сервер отвечает одной строкой JSON в формате GetAnalysisData()
+// с дополнительным полем "status" ("ok" или "error", в последнем случае — "message").
+// Заявки одного соединения можно слать пачкой, ответы приходят в том же порядке.
+int RunAnalysisService(const ServiceOptions& options);
+
+// Разбор аргументов командной строки; false если режим демона не запрошен
+bool ParseServiceOptions(int argc, char** argv, ServiceOptions& options);
@@ -0,0 +1,337 @@
+// Регрессионный прогон на эталонных синтетических фантомах.
+// Для каждого случая из golden-файла синтезируется размытый круг с шумом,
+// прогоняется полный расчёт (детекция + анализ + функция отклика) без GUI,
+// и результат сравнивается с эталоном: центр, радиус, ширина ESF и CNR.
+// Эталон перезаписывается (--update-golden) только вместе с намеренным изменением
+// алгоритма или синтеза фантомов, и новые значения проверяются глазами в диффе.
+// Заодно меряется время и сравнивается с сохранённым базовым замером —
+// только в Release-сборке: в Debug время ничего не говорит о реальной скорости.
+//
+// PhantomRegression --golden <file> [--baseline <file>] [--slowdown <factor>]
+//                   [--update-golden] [--update-baseline]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+
+// Задаётся CMake из $<CONFIG>
+#ifndef PHANTOM_BUILD_TYPE
+#define PHANTOM_BUILD_TYPE ""
+#endif
+
+namespace {
+
+const std::string timingBuildType = "Release";
+
+constexpr int timingSamples = 5;
+// Расчёт на фантоме занимает доли миллисекунды, поэтому один замер — серия вызовов
+// длиной не меньше timingSampleMs, а время вызова — среднее по серии
+constexpr double timingSampleMs = 20.0;
+// Замедление меньше этого порога считается шумом, в мс на вызов
+constexpr double timingNoiseFloorMs = 0.05;
+
+// На сколько пикселей профиль для ESF продлевается за найденный радиус
+constexpr int esfMargin = 12;
+
+struct Options {
+    std::string goldenPath;
+    std::string baselinePath;
+    double slowdown = 1.5;
+    bool updateGolden = false;
+    bool updateBaseline = false;
+};
+
+struct Measurement {
+    bool detected = false;
+    int centerX = 0;
+    int centerY = 0;
+    int radius = 0;
+    double esfWidth = 0;
+    double cnr = 0;
+    double timeMs = 0;
+};
+
+bool ReadJson(const std::string& path, json& data) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    try {
+        file >> data;
+    } catch (const json::exception& e) {
+        std::cerr << "Failed to parse " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WriteJson(const std::string& path, const json& data) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+    file << data.dump(4) << std::endl;
+    return true;
+}
+
+// Фантом в духе GenerateCircleImage, но с заданными контрастом, размытием и шумом
+cv::Mat MakePhantom(const json& phantom, int foreground, int background) {
+    int width = phantom["width"];
+    int height = phantom["height"];
+
+    cv::Mat image(height, width, CV_8UC1, cv::Scalar(background));
+    cv::circle(image, cv::Point(width/2, height/2), phantom["radius"].get<int>(), cv::Scalar(foreground), -1);
+
+    double blurSigma = phantom["blurSigma"];
+    if (blurSigma > 0) {
+        cv::GaussianBlur(image, image, cv::Size(), blurSigma, blurSigma);
+    }
+
+    double noiseSigma = phantom["noiseSigma"];
+    if (noiseSigma > 0) {
+        NoiseParams params;
+        params.sigma = noiseSigma;
+        params.seed = phantom["seed"].get<uint64_t>();
+        image = NoiseFilter(image, params);
+    }
+
+    return image;
+}
+
+// Ширина ESF — расстояние между уровнями 90% и 10% радиального профиля края.
+// Профиль снимается тем же AnalyzeImage, но вокруг истинного центра фантома и с радиусом
+// больше на esfMargin, чтобы край целиком попал в окно. От детекции метрика не зависит:
+// смещение центра на пиксель размыло бы усреднённый по кругу профиль сильнее, чем само
+// размытие края, и ESF мерила бы ошибку Hough. Точность детекции проверяют центр и радиус,
+// поэтому допуски ESF и центра независимы.
+double EsfWidth(AnalysisContext& context, const cv::Mat& image, const cv::Point& center, int radius) {
+    int outer = radius + esfMargin;
+    int inner = std::max(radius - esfMargin, 0);
+
+    ImageAnalysisResult extended;
+    AnalyzeImage(context, image, center, outer, extended);
+
+    // Профиль идёт от -outer до outer; если часть круга вышла за кадр, отсчётов меньше
+    const std::vector<double>& profile = extended.edgeProfile;
+    if (profile.size() != static_cast<size_t>(2 * outer + 1)) return 0;
+
+    // Половинки по разные стороны от центра усредняем
+    std::vector<double> radial(outer + 1);
+    for (int k = 0; k <= outer; ++k) {
+        radial[k] = (profile[outer + k] + profile[outer - k]) / 2;
+    }
+
+    double high = std::accumulate(radial.begin() + inner, radial.begin() + inner + 4, 0.0) / 4;
+    double low = std::accumulate(radial.end() - 4, radial.end(), 0.0) / 4;
+    double span = high - low;
+    if (span <= 0) return 0;
+
+    // Первое пересечение уровня при движении наружу, с линейной интерполяцией
+    auto crossing = [&](double level) {
+        for (int k = inner; k < outer; ++k) {
+            if (radial[k] >= level && radial[k + 1] < level) {
+                return k + (radial[k] - level) / (radial[k] - radial[k + 1]);
+            }
+        }
+        return -1.0;
+    };
+
+    double from = crossing(high - 0.1 * span);
+    double to = crossing(high - 0.9 * span);
+    if (from < 0 || to < 0) return 0;
+
+    return to - from;
+}
+
+Measurement Measure(AnalysisContext& context, const cv::Mat& image, const cv::Point& center, int radius) {
+    Measurement result;
+    ImageAnalysisResult analysis;
+    std::vector<float> responseFunction;
+
+    std::vector<double> times;
+    for (int sample = 0; sample < timingSamples; ++sample) {
+        int calls = 0;
+        double elapsed = 0;
+        auto start = std::chrono::steady_clock::now();
+        do {
+            result.detected = CalculateEdgeResponse(context, image, analysis, responseFunction);
+            ++calls;
+            elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < timingSampleMs);
+
+        times.push_back(elapsed / calls);
+    }
+
+    // медиана устойчивее к случайным задержкам планировщика
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    result.timeMs = times[times.size() / 2];
+
+    if (result.detected) {
+        result.centerX = analysis.centerX;
+        result.centerY = analysis.centerY;
+        result.radius = analysis.radius;
+        result.cnr = analysis.cnr;
+    }
+    result.esfWidth = EsfWidth(context, image, center, radius);
+
+    return result;
+}
+
+bool Within(double actual, double expected, double absolute, double relative = 0) {
+    return std::abs(actual - expected) <= absolute + relative * std::abs(expected);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--golden" && hasValue) {
+            options.goldenPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--slowdown" && hasValue) {
+            options.slowdown = std::atof(argv[++i]);
+        } else if (arg == "--update-golden") {
+            options.updateGolden = true;
+        } else if (arg == "--update-baseline") {
+            options.updateBaseline = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    return !options.goldenPath.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::cerr << "Usage: PhantomRegression --golden <file> [--baseline <file>] [--slowdown <factor>]"
+                     " [--update-golden] [--update-baseline]" << std::endl;
+        return 2;
+    }
+
+    json golden;
+    if (!ReadJson(options.goldenPath, golden)) {
+        std::cerr << "Cannot read golden file " << options.goldenPath << std::endl;
+        return 2;
+    }
+
+    // Время сравниваем и записываем только в Release-сборке.
+    // Без базового замера (первый запуск на машине) просто записываем текущий.
+    const std::string buildType = PHANTOM_BUILD_TYPE;
+    bool timingEnabled = !options.baselinePath.empty() && buildType == timingBuildType;
+    if (!options.baselinePath.empty() && !timingEnabled) {
+        std::cout << "Timing check skipped: " << (buildType.empty() ? "unknown" : buildType)
+                  << " build, baseline is recorded and compared in " << timingBuildType << " only" << std::endl;
+    }
+
+    json baseline = json::object();
+    bool haveBaseline = timingEnabled && !options.updateBaseline &&
+                        ReadJson(options.baselinePath, baseline);
+    if (haveBaseline && (baseline.value("buildType", "") != timingBuildType || !baseline.contains("cases"))) {
+        std::cout << "Ignoring baseline " << options.baselinePath << ": not a "
+                  << timingBuildType << " baseline" << std::endl;
+        haveBaseline = false;
+    }
+
+    const json& tolerances = golden["tolerances"];
+    int foreground = golden["foreground"];
+    int background = golden["background"];
+
+    // Прогрев: первые вызовы OpenCV тратят время на инициализацию
+    AnalysisContext context;
+    {
+        std::vector<float> responseFunction;
+        ImageAnalysisResult analysis;
+        CalculateEdgeResponse(context, MakePhantom(golden["cases"][0], foreground, background),
+                              analysis, responseFunction);
+    }
+
+    json timings = json::object();
+    int failures = 0;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (auto& phantom : golden["cases"]) {
+        const std::string name = phantom["name"];
+        const json& expected = phantom["expected"];
+
+        cv::Mat image = MakePhantom(phantom, foreground, background);
+        cv::Point center(phantom["width"].get<int>() / 2, phantom["height"].get<int>() / 2);
+        Measurement m = Measure(context, image, center, phantom["radius"].get<int>());
+        timings[name] = m.timeMs;
+
+        std::vector<std::string> errors;
+
+        if (!m.detected) {
+            errors.push_back("circle not detected");
+        } else if (options.updateGolden) {
+            phantom["expected"] = {
+                {"centerX", m.centerX}, {"centerY", m.centerY}, {"radius", m.radius},
+                {"esfWidth", std::round(m.esfWidth * 1000) / 1000},
+                {"cnr", std::round(m.cnr * 1000) / 1000}
+            };
+        } else {
+            double center = tolerances["center"];
+            if (!Within(m.centerX, expected["centerX"], center) || !Within(m.centerY, expected["centerY"], center)) {
+                errors.push_back("center (" + std::to_string(m.centerX) + ", " + std::to_string(m.centerY) + ")");
+            }
+            if (!Within(m.radius, expected["radius"], tolerances["radius"])) {
+                errors.push_back("radius " + std::to_string(m.radius));
+            }
+            if (!Within(m.esfWidth, expected["esfWidth"], tolerances["esfWidthAbsolute"], tolerances["esfWidthRelative"])) {
+                errors.push_back("ESF width " + std::to_string(m.esfWidth));
+            }
+            if (!Within(m.cnr, expected["cnr"], tolerances["cnrAbsolute"], tolerances["cnrRelative"])) {
+                errors.push_back("CNR " + std::to_string(m.cnr));
+            }
+        }
+
+        if (haveBaseline && baseline["cases"].contains(name)) {
+            double reference = baseline["cases"][name];
+            if (m.timeMs > reference * options.slowdown && m.timeMs - reference > timingNoiseFloorMs) {
+                errors.push_back("slow: " + std::to_string(m.timeMs) + " ms vs baseline " +
+                                 std::to_string(reference) + " ms");
+            }
+        }
+
+        std::cout << (errors.empty() ? "[ OK ] " : "[FAIL] ") << std::left << std::setw(32) << name
+                  << " r=" << m.radius << " esf=" << m.esfWidth << " cnr=" << m.cnr
+                  << " time=" << m.timeMs << " ms" << std::endl;
+        for (const auto& error : errors) {
+            std::cout << "         " << error << std::endl;
+        }
+
+        if (!errors.empty()) ++failures;
+    }
+
+    if (options.updateGolden) {
+        if (!WriteJson(options.goldenPath, golden)) {
+            std::cerr << "Cannot write golden file " << options.goldenPath << std::endl;
+            return 2;
+        }
+        std::cout << "Golden values updated" << std::endl;
+    }
+
+    if (timingEnabled && !haveBaseline) {
+        json record = {{"buildType", buildType}, {"cases", timings}};
+        if (!WriteJson(options.baselinePath, record)) {
+            std::cerr << "Cannot write baseline file " << options.baselinePath << std::endl;
+            return 2;
+        }
+        std::cout << "Timing baseline recorded to " << options.baselinePath << std::endl;
+    }
+
+    std::cout << failures << " of " << golden["cases"].size() << " cases failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}